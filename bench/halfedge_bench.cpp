@@ -0,0 +1,295 @@
+// halfedge_bench: microbenchmarks of the half-edge navigation primitives
+// CCW_edge_to_vertex, CW_edge_to_vertex, degree and incident_face are called on every half-edge,
+// vertex or face of a synthetic workload (workloads.hpp) in sequential, random and spatially sorted
+// order, with the checked (std::vector::at) and the unchecked (operator[]) access policies of the
+// triangulation. The median time per call of each combination and the overhead of the checked
+// policy are written to JSON.
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cstdint>
+#include <getopt.h>
+#include <workloads.hpp>
+
+enum primitive { CCW_EDGE_TO_VERTEX, CW_EDGE_TO_VERTEX, DEGREE, INCIDENT_FACE, N_PRIMITIVES };
+enum access_order { SEQUENTIAL, RANDOM, SPATIAL, N_ORDERS };
+
+static const char *primitive_names[N_PRIMITIVES] = {"CCW_edge_to_vertex", "CW_edge_to_vertex", "degree", "incident_face"};
+static const char *order_names[N_ORDERS] = {"sequential", "random", "spatial"};
+
+struct BenchOptions {
+    std::vector<std::string> workloads = {"grid", "random"};
+    std::vector<long long> sizes = {1000000};
+    int repetitions = 5;
+    unsigned int seed = 42;
+    std::string output = "halfedge_bench.json";
+};
+
+struct bench_result {
+    std::string workload;
+    long long n_triangles;
+    primitive prim;
+    access_order order;
+    long long n_calls;
+    double checked_ns;   //median ns per call
+    double unchecked_ns;
+};
+
+void print_usage(const char *program) {
+    std::cout << "Usage: " << program << " [OPTIONS]\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -w, --workloads LIST  Comma separated workloads: grid, random, pslg, fans, spirals (default: grid,random)\n";
+    std::cout << "  -n, --sizes LIST      Comma separated number of triangles, e.g. 1e4,1e6 (default: 1e6)\n";
+    std::cout << "  -r, --repetitions N   Repetitions of each measure (default: 5)\n";
+    std::cout << "      --seed N          Seed of the workloads and of the random order (default: 42)\n";
+    std::cout << "  -o, --output FILE     JSON results (default: halfedge_bench.json)\n";
+    std::cout << "  -h, --help            Show this help message\n";
+}
+
+std::vector<std::string> split_list(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+bool parse_arguments(int argc, char **argv, BenchOptions &options, bool &help) {
+    enum { OPT_SEED = 256 };
+    static struct option long_options[] = {
+        {"workloads",   required_argument, 0, 'w'},
+        {"sizes",       required_argument, 0, 'n'},
+        {"repetitions", required_argument, 0, 'r'},
+        {"seed",        required_argument, 0, OPT_SEED},
+        {"output",      required_argument, 0, 'o'},
+        {"help",        no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    try {
+        while ((c = getopt_long(argc, argv, "w:n:r:o:h", long_options, nullptr)) != -1) {
+            switch (c) {
+                case 'w':
+                    options.workloads = split_list(optarg);
+                    break;
+                case 'n':
+                    options.sizes.clear();
+                    for (const std::string &size : split_list(optarg))
+                        options.sizes.push_back(static_cast<long long>(std::stod(size)));
+                    break;
+                case 'r':
+                    options.repetitions = std::stoi(optarg);
+                    break;
+                case OPT_SEED:
+                    options.seed = static_cast<unsigned int>(std::stoul(optarg));
+                    break;
+                case 'o':
+                    options.output = optarg;
+                    break;
+                case 'h':
+                    help = true;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: invalid number in the arguments" << std::endl;
+        return false;
+    }
+
+    if (options.repetitions < 1 || options.sizes.empty() || options.workloads.empty()) {
+        std::cerr << "Error: repetitions, sizes and workloads must not be empty" << std::endl;
+        return false;
+    }
+    for (long long size : options.sizes) {
+        if (size < 2) {
+            std::cerr << "Error: sizes must be at least 2 triangles" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    std::size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+//Morton key of each vertex of the workload, on the grid of its bounding box (spatial_sort.hpp)
+std::vector<std::uint32_t> vertex_keys(const Workload &workload) {
+    const int n = workload.n_vertices();
+    double min_x = workload.xy[0], max_x = min_x, min_y = workload.xy[1], max_y = min_y;
+    for (int v = 0; v < n; v++) {
+        min_x = std::min(min_x, workload.xy[2*v]);
+        max_x = std::max(max_x, workload.xy[2*v]);
+        min_y = std::min(min_y, workload.xy[2*v+1]);
+        max_y = std::max(max_y, workload.xy[2*v+1]);
+    }
+    const CurveGrid grid(min_x, min_y, max_x, max_y, CURVE_MORTON);
+    std::vector<std::uint32_t> keys(n);
+    for (int v = 0; v < n; v++)
+        keys[v] = grid.key(workload.xy[2*v], workload.xy[2*v+1]);
+    return keys;
+}
+
+//Indices [0, n) in the given order, key(i) is the Morton key of the element i
+template <typename K>
+std::vector<int> make_order(const int n, const access_order order, std::mt19937 &rng, K key) {
+    std::vector<int> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    if (order == RANDOM) {
+        std::shuffle(indices.begin(), indices.end(), rng);
+    } else if (order == SPATIAL) {
+        std::vector<std::uint32_t> keys(n);
+        for (int i = 0; i < n; i++) keys[i] = key(i);
+        std::stable_sort(indices.begin(), indices.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+    }
+    return indices;
+}
+
+//Call the primitive on each element of order, the sum of the results keeps the calls from being optimized out
+template <typename Access>
+long long run_primitive(BasicTriangulation<Access> &mesh, const primitive prim, const std::vector<int> &order) {
+    long long sum = 0;
+    switch (prim) {
+        case CCW_EDGE_TO_VERTEX:
+            for (int e : order) sum += mesh.CCW_edge_to_vertex(e);
+            break;
+        case CW_EDGE_TO_VERTEX:
+            for (int e : order) sum += mesh.CW_edge_to_vertex(e);
+            break;
+        case DEGREE:
+            for (int v : order) sum += mesh.degree(v);
+            break;
+        default:
+            for (int f : order) {
+                auto face = mesh.incident_face(mesh.incident_halfedge(f));
+                sum += face[0] + face[1] + face[2];
+            }
+            break;
+    }
+    return sum;
+}
+
+//Median ns per call of the primitive
+template <typename Access>
+double time_primitive(BasicTriangulation<Access> &mesh, const primitive prim, const std::vector<int> &order,
+                      const int repetitions, long long &checksum) {
+    std::vector<double> times;
+    for (int rep = 0; rep < repetitions; rep++) {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        checksum += run_primitive(mesh, prim, order);
+        auto t_end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::nano>(t_end - t_start).count() / order.size());
+    }
+    return median(times);
+}
+
+std::vector<bench_result> run_workload(const Workload &workload, const BenchOptions &options, long long &checksum) {
+    std::unique_ptr<BasicTriangulation<checked_access>> checked(workload.to_triangulation<checked_access>());
+    std::unique_ptr<BasicTriangulation<unchecked_access>> unchecked(workload.to_triangulation<unchecked_access>());
+    const std::vector<std::uint32_t> keys = vertex_keys(workload);
+    std::mt19937 rng(options.seed);
+
+    std::vector<bench_result> results;
+    for (int p = 0; p < N_PRIMITIVES; p++) {
+        primitive prim = static_cast<primitive>(p);
+        for (int o = 0; o < N_ORDERS; o++) {
+            access_order order = static_cast<access_order>(o);
+            std::vector<int> indices;
+            if (prim == DEGREE)
+                indices = make_order(checked->vertices(), order, rng, [&](int v) { return keys[v]; });
+            else if (prim == INCIDENT_FACE)
+                indices = make_order(checked->faces(), order, rng, [&](int f) { return keys[checked->origin(checked->incident_halfedge(f))]; });
+            else
+                indices = make_order(checked->halfEdges(), order, rng, [&](int e) { return keys[checked->origin(e)]; });
+            //vertices that are not in any triangle have no edges to rotate around
+            if (prim == DEGREE)
+                indices.erase(std::remove_if(indices.begin(), indices.end(), [&](int v) { return checked->edge_of_vertex(v) < 0; }), indices.end());
+            if (indices.empty()) continue;
+
+            bench_result result = {workload.name, workload.n_triangles(), prim, order, static_cast<long long>(indices.size()), 0, 0};
+            result.checked_ns = time_primitive(*checked, prim, indices, options.repetitions, checksum);
+            result.unchecked_ns = time_primitive(*unchecked, prim, indices, options.repetitions, checksum);
+            results.push_back(result);
+        }
+    }
+    return results;
+}
+
+void print_result(const bench_result &result) {
+    std::cout << "  " << std::left << std::setw(20) << primitive_names[result.prim] << std::setw(12) << order_names[result.order] << std::right
+              << std::fixed << std::setprecision(2)
+              << " checked " << std::setw(8) << result.checked_ns << " ns"
+              << "  unchecked " << std::setw(8) << result.unchecked_ns << " ns"
+              << "  overhead " << std::setw(6) << (result.unchecked_ns > 0 ? result.checked_ns / result.unchecked_ns : 0) << "x"
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+void write_json(const std::string &filename, const BenchOptions &options, const std::vector<bench_result> &results) {
+    std::ofstream out(filename);
+    out<<"{"<<std::endl;
+    out<<"\"repetitions\": "<<options.repetitions<<","<<std::endl;
+    out<<"\"seed\": "<<options.seed<<","<<std::endl;
+    out<<"\"results\": ["<<std::endl;
+    for (std::size_t r = 0; r < results.size(); r++) {
+        const bench_result &result = results[r];
+        out<<"{\"workload\": \""<<result.workload<<"\", \"n_triangles\": "<<result.n_triangles
+           <<", \"primitive\": \""<<primitive_names[result.prim]<<"\", \"order\": \""<<order_names[result.order]
+           <<"\", \"calls\": "<<result.n_calls
+           <<", \"checked_ns_per_call\": "<<result.checked_ns<<", \"unchecked_ns_per_call\": "<<result.unchecked_ns
+           <<", \"checked_overhead\": "<<(result.unchecked_ns > 0 ? result.checked_ns / result.unchecked_ns : 0)<<"}"
+           <<(r + 1 < results.size() ? "," : "")<<std::endl;
+    }
+    out<<"]"<<std::endl;
+    out<<"}"<<std::endl;
+    out.close();
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    bool help = false;
+    if (!parse_arguments(argc, argv, options, help)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+
+    std::vector<bench_result> results;
+    long long checksum = 0;
+    try {
+        for (const std::string &name : options.workloads) {
+            for (long long size : options.sizes) {
+                Workload workload = make_workload(name, size, options.seed);
+                std::cout << workload.name << ": " << workload.n_triangles() << " triangles, " << workload.n_vertices() << " vertices" << std::endl;
+                for (const bench_result &result : run_workload(workload, options, checksum)) {
+                    print_result(result);
+                    results.push_back(result);
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    write_json(options.output, options, results);
+    std::cout << "output benchmark in " << options.output << " (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,381 @@
+// polylla_bench: benchmark of the Polylla phases on synthetic workloads
+// Each workload is generated in memory (workloads.hpp), every phase is run --repetitions times
+// and the median and minimum time and the triangles per second of each phase are written to JSON.
+// --threads runs the same mesh with each thread count (strong scaling), with --weak the size
+// is multiplied by the number of threads (weak scaling). With --workspace the repetitions borrow
+// their arrays from a Workspace (storage.hpp) and the heap allocations of the last one are reported.
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <getopt.h>
+#include <polylla.hpp>
+#include <workloads.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+struct BenchOptions {
+    std::vector<std::string> workloads = {"grid", "random"};
+    std::vector<long long> sizes = {10000, 100000};
+    std::vector<int> threads;
+    int repetitions = 5;
+    bool weak_scaling = false;
+    bool workspace = false;
+    unsigned int seed = 42;
+    bool verbose = false;
+    std::string output = "polylla_bench.json";
+    PolyllaOptions polylla_options;
+    BarrierTipOptions tips;
+};
+
+struct phase_times {
+    std::string name;
+    std::vector<double> times; //ms, one per repetition
+};
+
+struct bench_result {
+    std::string workload;
+    long long n_triangles;
+    int n_vertices;
+    int n_polygons;
+    int n_barrier_edge_tips;
+    int n_polygons_to_repair;
+    int threads;
+    long long heap_allocations; //allocations of the mesh and Polylla in the last repetition, -1 if unavailable
+    std::vector<phase_times> phases;
+};
+
+//Stream buffer that discards the output of the library while the phases run
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+//std::cout writes to buffer from the construction to the destruction of the scope, also when a phase throws
+class CoutScope {
+private:
+    std::streambuf *saved;
+
+public:
+    explicit CoutScope(std::streambuf *buffer) : saved(std::cout.rdbuf(buffer)) {}
+
+    ~CoutScope() {
+        std::cout.rdbuf(saved);
+    }
+
+    CoutScope(const CoutScope&) = delete;
+    CoutScope& operator=(const CoutScope&) = delete;
+};
+
+void print_usage(const char *program) {
+    std::cout << "Usage: " << program << " [OPTIONS]\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -w, --workloads LIST  Comma separated workloads: grid, random, pslg, fans, spirals (default: grid,random)\n";
+    std::cout << "  -n, --sizes LIST      Comma separated number of triangles, e.g. 1e4,1e6 (default: 1e4,1e5)\n";
+    std::cout << "  -r, --repetitions N   Repetitions of each phase (default: 5)\n";
+    std::cout << "  -t, --threads LIST    Comma separated thread counts (default: all the threads)\n";
+    std::cout << "      --weak            Weak scaling: the size is per thread\n";
+    std::cout << "      --workspace       Reuse the arrays of the previous repetition from a workspace\n";
+    std::cout << "      --tip-degree K    Triangles around each barrier-edge tip of fans and spirals (default: 16)\n";
+    std::cout << "      --tip-density D   Fraction of the sites of fans and spirals with a tip, in (0, 1] (default: 1)\n";
+    std::cout << "  -s, --smooth METHOD   Include a smoothing phase: laplacian, laplacian-edge-ratio, distmesh, laplacian-cg\n";
+    std::cout << "  -i, --iterations N    Smoothing iterations (default: 50)\n";
+    std::cout << "      --seed N          Seed of the random workloads (default: 42)\n";
+    std::cout << "  -o, --output FILE     JSON results (default: polylla_bench.json)\n";
+    std::cout << "  -v, --verbose         Keep the output of Polylla\n";
+    std::cout << "  -h, --help            Show this help message\n";
+}
+
+std::vector<std::string> split_list(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+bool parse_arguments(int argc, char **argv, BenchOptions &options, bool &help) {
+    enum { OPT_WEAK = 256, OPT_WORKSPACE, OPT_SEED, OPT_TIP_DEGREE, OPT_TIP_DENSITY };
+    static struct option long_options[] = {
+        {"workloads",   required_argument, 0, 'w'},
+        {"sizes",       required_argument, 0, 'n'},
+        {"repetitions", required_argument, 0, 'r'},
+        {"threads",     required_argument, 0, 't'},
+        {"weak",        no_argument,       0, OPT_WEAK},
+        {"workspace",   no_argument,       0, OPT_WORKSPACE},
+        {"smooth",      required_argument, 0, 's'},
+        {"iterations",  required_argument, 0, 'i'},
+        {"seed",        required_argument, 0, OPT_SEED},
+        {"tip-degree",  required_argument, 0, OPT_TIP_DEGREE},
+        {"tip-density", required_argument, 0, OPT_TIP_DENSITY},
+        {"output",      required_argument, 0, 'o'},
+        {"verbose",     no_argument,       0, 'v'},
+        {"help",        no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    try {
+        while ((c = getopt_long(argc, argv, "w:n:r:t:s:i:o:vh", long_options, nullptr)) != -1) {
+            switch (c) {
+                case 'w':
+                    options.workloads = split_list(optarg);
+                    break;
+                case 'n':
+                    options.sizes.clear();
+                    for (const std::string &size : split_list(optarg))
+                        options.sizes.push_back(static_cast<long long>(std::stod(size)));
+                    break;
+                case 'r':
+                    options.repetitions = std::stoi(optarg);
+                    break;
+                case 't':
+                    options.threads.clear();
+                    for (const std::string &t : split_list(optarg))
+                        options.threads.push_back(std::stoi(t));
+                    break;
+                case OPT_WEAK:
+                    options.weak_scaling = true;
+                    break;
+                case OPT_WORKSPACE:
+                    options.workspace = true;
+                    break;
+                case 's':
+                    options.polylla_options.smooth_method = optarg;
+                    break;
+                case 'i':
+                    options.polylla_options.smooth_iterations = std::stoi(optarg);
+                    break;
+                case OPT_SEED:
+                    options.seed = static_cast<unsigned int>(std::stoul(optarg));
+                    break;
+                case OPT_TIP_DEGREE:
+                    options.tips.tip_degree = std::stoi(optarg);
+                    break;
+                case OPT_TIP_DENSITY:
+                    options.tips.tip_density = std::stod(optarg);
+                    break;
+                case 'o':
+                    options.output = optarg;
+                    break;
+                case 'v':
+                    options.verbose = true;
+                    break;
+                case 'h':
+                    help = true;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: invalid number in the arguments" << std::endl;
+        return false;
+    }
+
+    if (options.repetitions < 1 || options.sizes.empty() || options.workloads.empty()) {
+        std::cerr << "Error: repetitions, sizes and workloads must not be empty" << std::endl;
+        return false;
+    }
+    for (long long size : options.sizes) {
+        if (size < 2) {
+            std::cerr << "Error: sizes must be at least 2 triangles" << std::endl;
+            return false;
+        }
+    }
+    for (int t : options.threads) {
+        if (t < 1) {
+            std::cerr << "Error: thread counts must be positive" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void add_time(std::vector<phase_times> &phases, const std::string &name, const double time) {
+    for (phase_times &phase : phases) {
+        if (phase.name == name) {
+            phase.times.push_back(time);
+            return;
+        }
+    }
+    phases.push_back({name, {time}});
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    std::size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+//Run every phase options.repetitions times on the workload with the given number of threads
+bench_result run_workload(const Workload &workload, const int threads, const BenchOptions &options) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    bench_result result = {workload.name, workload.n_triangles(), workload.n_vertices(), 0, 0, 0, threads, -1, {}};
+    NullBuffer null_buffer;
+    Workspace workspace;
+    std::unique_ptr<WorkspaceScope> workspace_scope;
+    if (options.workspace) workspace_scope.reset(new WorkspaceScope(workspace));
+
+    for (int rep = 0; rep < options.repetitions; rep++) {
+        CoutScope quiet(options.verbose ? std::cout.rdbuf() : &null_buffer);
+
+        const long long allocations_start = MemoryStats::heap_allocations();
+        Triangulation *mesh = workload.to_triangulation();
+        auto t_start = std::chrono::high_resolution_clock::now();
+        Polylla polylla(mesh, options.polylla_options); //takes the ownership of mesh
+        auto t_end = std::chrono::high_resolution_clock::now();
+        double t_polylla = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+        if (MemoryStats::heap_available())
+            result.heap_allocations = MemoryStats::heap_allocations() - allocations_start;
+
+        t_start = std::chrono::high_resolution_clock::now();
+        PolygonMesh polygon_mesh = polylla.get_polygon_mesh();
+        t_end = std::chrono::high_resolution_clock::now();
+        double t_polygon_mesh = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+
+        add_time(result.phases, "construct_halfedges", mesh->get_triangulation_generation_time());
+        if (!options.polylla_options.smooth_method.empty())
+            add_time(result.phases, "smooth", polylla.get_smooth_time());
+        add_time(result.phases, "label_max_edges", polylla.get_label_max_edges_time());
+        add_time(result.phases, "label_frontier_edges", polylla.get_label_frontier_edges_time());
+        add_time(result.phases, "label_seed_edges", polylla.get_label_seed_edges_time());
+        add_time(result.phases, "traversal", polylla.get_traversal_time());
+        add_time(result.phases, "repair", polylla.get_repair_time());
+        add_time(result.phases, "polylla_total", t_polylla);
+        add_time(result.phases, "get_polygon_mesh", t_polygon_mesh);
+        result.n_polygons = static_cast<int>(polygon_mesh.n_polygons());
+        result.n_barrier_edge_tips = polylla.get_n_barrier_edge_tips();
+        result.n_polygons_to_repair = polylla.get_n_polygons_to_repair();
+    }
+    return result;
+}
+
+void print_result(const bench_result &result) {
+    std::cout << result.workload << ": " << result.n_triangles << " triangles, " << result.n_polygons << " polygons, "
+              << result.n_barrier_edge_tips << " barrier-edge tips, " << result.n_polygons_to_repair << " repaired polygons, "
+              << result.threads << " threads";
+    if (result.heap_allocations >= 0)
+        std::cout << ", " << result.heap_allocations << " heap allocations per mesh";
+    std::cout << std::endl;
+    for (const phase_times &phase : result.phases) {
+        double med = median(phase.times);
+        std::cout << "  " << std::left << std::setw(22) << phase.name << std::right
+                  << " median " << std::setw(10) << std::fixed << std::setprecision(3) << med << " ms"
+                  << "  min " << std::setw(10) << *std::min_element(phase.times.begin(), phase.times.end()) << " ms"
+                  << "  " << std::setprecision(0) << (med > 0 ? result.n_triangles / (med / 1000) : 0) << " triangles/s";
+        if (phase.name == "repair")
+            std::cout << "  " << (med > 0 ? result.n_polygons_to_repair / (med / 1000) : 0) << " repaired polygons/s";
+        std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+}
+
+void write_json(const std::string &filename, const BenchOptions &options, const std::vector<bench_result> &results) {
+    std::ofstream out(filename);
+    out<<"{"<<std::endl;
+    out<<"\"repetitions\": "<<options.repetitions<<","<<std::endl;
+    out<<"\"scaling\": \""<<(options.weak_scaling ? "weak" : "strong")<<"\","<<std::endl;
+    out<<"\"workspace\": "<<(options.workspace ? "true" : "false")<<","<<std::endl;
+    out<<"\"seed\": "<<options.seed<<","<<std::endl;
+    out<<"\"smooth_method\": \""<<options.polylla_options.smooth_method<<"\","<<std::endl;
+    out<<"\"results\": ["<<std::endl;
+    for (std::size_t r = 0; r < results.size(); r++) {
+        const bench_result &result = results[r];
+        //speedup (efficiency with weak scaling) of polylla_total against the first thread count of the same problem
+        double speedup = 1;
+        for (std::size_t b = 0; b < r; b++) {
+            const bench_result &base = results[b];
+            bool same_problem = base.workload == result.workload &&
+                (options.weak_scaling ? base.n_triangles / base.threads == result.n_triangles / result.threads : base.n_triangles == result.n_triangles);
+            if (!same_problem) continue;
+            auto total = [](const bench_result &res) {
+                for (const phase_times &phase : res.phases)
+                    if (phase.name == "polylla_total") return median(phase.times);
+                return 0.0;
+            };
+            if (total(result) > 0) speedup = total(base) / total(result);
+            break;
+        }
+        out<<"{\"workload\": \""<<result.workload<<"\", \"n_triangles\": "<<result.n_triangles
+           <<", \"n_vertices\": "<<result.n_vertices<<", \"n_polygons\": "<<result.n_polygons
+           <<", \"n_barrier_edge_tips\": "<<result.n_barrier_edge_tips<<", \"n_polygons_to_repair\": "<<result.n_polygons_to_repair
+           <<", \"threads\": "<<result.threads<<", \"heap_allocations\": "<<result.heap_allocations
+           <<", \""<<(options.weak_scaling ? "efficiency" : "speedup")<<"\": "<<speedup<<","<<std::endl;
+        out<<" \"phases\": {"<<std::endl;
+        for (std::size_t p = 0; p < result.phases.size(); p++) {
+            const phase_times &phase = result.phases[p];
+            double med = median(phase.times);
+            out<<"  \""<<phase.name<<"\": {\"median_ms\": "<<med
+               <<", \"min_ms\": "<<*std::min_element(phase.times.begin(), phase.times.end())
+               <<", \"triangles_per_second\": "<<(med > 0 ? result.n_triangles / (med / 1000) : 0);
+            //the repair is measured per repaired polygon
+            if (phase.name == "repair")
+                out<<", \"repaired_polygons_per_second\": "<<(med > 0 ? result.n_polygons_to_repair / (med / 1000) : 0);
+            out<<"}"
+               <<(p + 1 < result.phases.size() ? "," : "")<<std::endl;
+        }
+        out<<" }}"<<(r + 1 < results.size() ? "," : "")<<std::endl;
+    }
+    out<<"]"<<std::endl;
+    out<<"}"<<std::endl;
+    out.close();
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    bool help = false;
+    if (!parse_arguments(argc, argv, options, help)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+
+    int max_threads = 1;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    if (options.threads.empty()) options.threads.push_back(max_threads);
+#ifndef _OPENMP
+    if (options.threads.size() > 1 || options.threads[0] != 1)
+        std::cout << "Compiled without OpenMP, running with 1 thread" << std::endl;
+    options.threads = {1};
+#endif
+
+    std::vector<bench_result> results;
+    try {
+        for (const std::string &name : options.workloads) {
+            for (long long size : options.sizes) {
+                std::unique_ptr<Workload> workload;
+                for (int threads : options.threads) {
+                    //strong scaling reuses the mesh for every thread count
+                    if (!workload || options.weak_scaling)
+                        workload.reset(new Workload(make_workload(name, options.weak_scaling ? size * threads : size, options.seed, options.tips)));
+                    bench_result result = run_workload(*workload, threads, options);
+                    print_result(result);
+                    results.push_back(result);
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    write_json(options.output, options, results);
+    std::cout << "output benchmark in " << options.output << std::endl;
+    return 0;
+}
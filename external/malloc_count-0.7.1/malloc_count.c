@@ -32,6 +32,9 @@
 #include <stdio.h>
 #include <locale.h>
 #include <dlfcn.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
 
 #include "malloc_count.h"
 
@@ -41,7 +44,9 @@ static const int log_operations = 0;    /* <-- set this to 1 for log output */
 static const size_t log_operations_threshold = 1024*1024;
 
 /* option to use gcc's intrinsics to do thread-safe statistics operations */
+#ifndef THREAD_SAFE_GCC_INTRINSICS
 #define THREAD_SAFE_GCC_INTRINSICS      0
+#endif
 
 /* to each allocation additional data is added for bookkeeping. due to
  * alignment requirements, we can optionally add more than just one integer. */
@@ -59,6 +64,10 @@ static realloc_type real_realloc = NULL;
 /* a sentinel value prefixed to each allocation */
 static const size_t sentinel = 0xDEADC0DE;
 
+/* the sentinel of allocations with a larger alignment, which also store the
+ * pointer to the enclosing malloc() block before the allocation size */
+static const size_t aligned_sentinel = 0xA11C0DE;
+
 /* a simple memory heap for allocations prior to dlsym loading */
 #define INIT_HEAP_SIZE 1024*1024
 static char init_heap[INIT_HEAP_SIZE];
@@ -72,7 +81,7 @@ static const int log_operations_init_heap = 0;
 /* run-time memory allocation statistics */
 /*****************************************/
 
-static long long peak = 0, curr = 0, total = 0;
+static long long peak = 0, curr = 0, total = 0, num_allocs = 0;
 
 static malloc_count_callback_type callback = NULL;
 static void* callback_cookie = NULL;
@@ -84,10 +93,12 @@ static void inc_count(size_t inc)
     long long mycurr = __sync_add_and_fetch(&curr, inc);
     if (mycurr > peak) peak = mycurr;
     total += inc;
+    __sync_add_and_fetch(&num_allocs, 1);
     if (callback) callback(callback_cookie, mycurr);
 #else
     if ((curr += inc) > peak) peak = curr;
     total += inc;
+    ++num_allocs;
     if (callback) callback(callback_cookie, curr);
 #endif
 }
@@ -116,6 +127,12 @@ extern size_t malloc_count_peak(void)
     return peak;
 }
 
+/* user function to return the number of allocations */
+extern size_t malloc_count_num_allocs(void)
+{
+    return num_allocs;
+}
+
 /* user function to reset the peak allocation to current */
 extern void malloc_count_reset_peak(void)
 {
@@ -149,8 +166,11 @@ extern void* malloc(size_t size)
 
     if (real_malloc)
     {
-        /* call read malloc procedure in libc */
+        /* call read malloc procedure in libc, a failed allocation is not
+         * counted and returns NULL, operator new then throws std::bad_alloc */
+        if (size > (size_t)-1 - alignment) return NULL;
         ret = (*real_malloc)(alignment + size);
+        if (!ret) return NULL;
 
         inc_count(size);
         if (log_operations && size >= log_operations_threshold) {
@@ -203,6 +223,11 @@ extern void free(void* ptr)
         return;
     }
 
+    if (*(size_t*)((char*)ptr - sizeof(size_t)) == aligned_sentinel) {
+        free(*(void**)((char*)ptr - 3 * sizeof(size_t)));
+        return;
+    }
+
     if (!real_free) {
         fprintf(stderr, PPREFIX
                 "free(%p) outside init heap and without real_free !!!\n", ptr);
@@ -232,9 +257,11 @@ extern void free(void* ptr)
 extern void* calloc(size_t nmemb, size_t size)
 {
     void* ret;
+    if (nmemb != 0 && size > (size_t)-1 / nmemb) return NULL;
     size *= nmemb;
     if (!size) return NULL;
     ret = malloc(size);
+    if (!ret) return NULL;
     memset(ret, 0, size);
     return ret;
 }
@@ -271,6 +298,7 @@ extern void* realloc(void* ptr, size_t size)
             /* allocate new area and copy data */
             ptr = (char*)ptr + alignment;
             newptr = malloc(size);
+            if (!newptr) return NULL;
             memcpy(newptr, ptr, oldsize);
             free(ptr);
             return newptr;
@@ -286,6 +314,16 @@ extern void* realloc(void* ptr, size_t size)
         return malloc(size);
     }
 
+    if (*(size_t*)((char*)ptr - sizeof(size_t)) == aligned_sentinel) {
+        /* the alignment is not kept, as with realloc() in libc */
+        oldsize = *(size_t*)((char*)ptr - 2 * sizeof(size_t));
+        newptr = malloc(size);
+        if (!newptr) return NULL;
+        memcpy(newptr, ptr, oldsize < size ? oldsize : size);
+        free(ptr);
+        return newptr;
+    }
+
     ptr = (char*)ptr - alignment;
 
     if (*(size_t*)((char*)ptr + alignment - sizeof(size_t)) != sentinel) {
@@ -295,11 +333,14 @@ extern void* realloc(void* ptr, size_t size)
 
     oldsize = *(size_t*)ptr;
 
+    /* a failed realloc keeps the old block and its count */
+    if (size > (size_t)-1 - alignment) return NULL;
+    newptr = (*real_realloc)(ptr, alignment + size);
+    if (!newptr) return NULL;
+
     dec_count(oldsize);
     inc_count(size);
 
-    newptr = (*real_realloc)(ptr, alignment + size);
-
     if (log_operations && size >= log_operations_threshold)
     {
         if (newptr == ptr)
@@ -317,11 +358,63 @@ extern void* realloc(void* ptr, size_t size)
     return (char*)newptr + alignment;
 }
 
+/* aligned allocation inside a malloc() block, the block pointer, size and
+ * aligned_sentinel are stored right before the returned pointer. Without this,
+ * blocks from the aligned allocators in libc (used by libgomp) reach free() */
+static void* aligned_malloc(size_t align, size_t size)
+{
+    char* block;
+    char* ret;
+
+    if (align <= alignment) return malloc(size);
+
+    block = malloc(size + align + 3 * sizeof(size_t));
+    if (!block) return NULL;
+
+    ret = (char*)(((uintptr_t)block + 3 * sizeof(size_t) + align - 1) & ~(uintptr_t)(align - 1));
+    *(void**)(ret - 3 * sizeof(size_t)) = block;
+    *(size_t*)(ret - 2 * sizeof(size_t)) = size;
+    *(size_t*)(ret - sizeof(size_t)) = aligned_sentinel;
+
+    return ret;
+}
+
+/* exported aligned allocation symbols that override loading from libc */
+extern int posix_memalign(void** memptr, size_t align, size_t size)
+{
+    void* ret;
+    if (align == 0 || (align & (align - 1)) || align % sizeof(void*))
+        return EINVAL;
+    ret = aligned_malloc(align, size);
+    if (!ret) return ENOMEM;
+    *memptr = ret;
+    return 0;
+}
+
+extern void* aligned_alloc(size_t align, size_t size)
+{
+    if (align == 0 || (align & (align - 1))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return aligned_malloc(align, size);
+}
+
+extern void* memalign(size_t align, size_t size)
+{
+    return aligned_alloc(align, size);
+}
+
+extern void* valloc(size_t size)
+{
+    return aligned_malloc((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
 static __attribute__((constructor)) void init(void)
 {
     char *error;
 
-    setlocale(LC_NUMERIC, ""); /* for better readable numbers */
+    /* no setlocale(LC_NUMERIC, ""): it would change how the program parses numbers */
 
     dlerror();
 
@@ -344,11 +437,15 @@ static __attribute__((constructor)) void init(void)
     }
 }
 
+/* The summary on exit is only printed with MALLOC_COUNT_SUMMARY, Polylla writes the counters to
+ * its JSON stats and its stderr is part of the --stdout pipelines */
+#ifdef MALLOC_COUNT_SUMMARY
 static __attribute__((destructor)) void finish(void)
 {
     fprintf(stderr, PPREFIX
             "exiting, total: %'lld, peak: %'lld, current: %'lld\n",
             total, peak, curr);
 }
+#endif
 
 /*****************************************************************************/
@@ -3,10 +3,31 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
 #include <getopt.h>
+#include <poll.h>
 #include <polylla.hpp>
 #include <triangulation.hpp>
+#include <trace.hpp>
+#include <perf_counters.hpp>
+#include <numa.hpp>
+#include <workloads.hpp>
+#include <serve_protocol.hpp>
 #include <filesystem>
+#include <type_traits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // Conditional CUDA includes
 #ifdef CUDA_AVAILABLE
@@ -14,8 +35,8 @@
 #endif
 
 struct ProgramOptions {
-    enum InputType { NONE, OFF, NEIGH, ELE, POLY };
-    enum OutputFormat { OFF_FORMAT };
+    enum InputType { NONE, OFF, NEIGH, ELE, POLY, GENERATE, BATCH, SERVE, ARRAYS };
+    enum OutputFormat { OFF_FORMAT, VTU_FORMAT, PLY_FORMAT };
     
     InputType input_type = NONE;
     OutputFormat output_format = OFF_FORMAT;  // Default format
@@ -26,6 +47,26 @@ struct ProgramOptions {
     std::string poly_file;
     std::string triangle_args = "pnz";  // Default triangle arguments
     std::string output_name;
+    std::string trace_file;  // Chrome trace-event output, empty = no tracing
+    bool perf_counters = false;  // Hardware counters per phase in the JSON stats
+    std::string storage = "heap";  // Backing of the triangulation arrays: heap, hugepages or file
+    std::string storage_dir;  // Directory of the file storage, empty = $TMPDIR or /tmp
+    std::string pin = "none";  // Pinning of the OpenMP threads: none, cores or nodes
+    bool to_stdout = false;  // Write the mesh to stdout and the messages to stderr
+    
+    // Batch mode (--batch)
+    std::string batch_file;  // Manifest with one input and its options per line
+    int batch_jobs = 0;  // Worker threads, 0 = one per OpenMP thread
+    std::vector<std::string> batch_arguments;  // Options of the command line, applied to every item
+    std::string sweep_file;  // Configurations of --sweep, one per line
+    std::string serve_socket;  // Unix socket of --serve
+    long long serve_max_triangles = 50000000;  // Largest mesh request of --serve, its arrays are allocated before they arrive
+    
+    // Generated input (--generate)
+    std::string workload;
+    long long workload_size = 100000;  // Approximate number of triangles
+    unsigned int workload_seed = 42;
+    BarrierTipOptions workload_tips;
     
     // Polylla options
     PolyllaOptions polylla_options;
@@ -58,6 +99,12 @@ bool validate_polylla_options(const PolyllaOptions& options) {
         return false;
     }
     
+    // The input order can only be restored after a reorder
+    if (options.restore_vertex_order && options.reorder.empty()) {
+        std::cerr << "Error: --restore-order requires --reorder" << std::endl;
+        return false;
+    }
+    
     // Could add more business logic validations here in the future
     // e.g., combination of options that don't make sense together
     
@@ -71,7 +118,24 @@ void print_usage(const char* program_name) {
     std::cout << "  -n, --neigh          Use .node, .ele, and .neigh files as input\n";
     std::cout << "  -e, --ele            Use .node and .ele files as input (without .neigh)\n";
     std::cout << "  -p, --poly           Use .poly file as input (requires Triangle)\n";
-    std::cout << "  -p:ARGS              Use .poly file with custom Triangle arguments\n\n";
+    std::cout << "  -p:ARGS              Use .poly file with custom Triangle arguments\n";
+    std::cout << "  FILES = -            Read the input of --off, --neigh or --ele from stdin (--neigh: the .node,\n";
+    std::cout << "                       .ele and .neigh files one after the other, --ele: .node and .ele)\n";
+    std::cout << "      --pipelined-read With --neigh, read the three files on their own threads while the\n";
+    std::cout << "                       half-edges are built from the triangles already read\n";
+    std::cout << "      --generate NAME  Generate the input triangulation: grid, random, pslg, or fans and spirals\n";
+    std::cout << "                       (barrier-edge tips of degree --tip-degree to benchmark the repair),\n";
+    std::cout << "                       the outputs are OUTPUT if given, else NAME_SIZE with the seed and tip\n";
+    std::cout << "                       options that are not the default and the _polylla suffix\n";
+    std::cout << "      --batch FILE     Process every line of FILE (an input mode, its files and options) on a\n";
+    std::cout << "                       pool of workers and write a summary to FILE_batch.json\n";
+    std::cout << "      --sweep FILE     Read the input once and run every configuration of FILE (one line of\n";
+    std::cout << "                       options each) on it concurrently, the outputs of line k are OUTPUT_k\n";
+    std::cout << "      --serve SOCKET   Serve the requests of tools/polylla_client (files or inline arrays) over\n";
+    std::cout << "                       a Unix domain socket until a shutdown request, SIGINT or SIGTERM\n";
+    std::cout << "      --serve-max-triangles N\n";
+    std::cout << "                       Largest inline mesh accepted by --serve (default: 50000000)\n";
+    std::cout << "      --jobs N         Workers of --batch, --sweep and --serve (default: one per OpenMP thread)\n\n";
     std::cout << "Triangle integration (.poly files):\n";
     std::cout << "  Basic usage:\n";
     std::cout << "    " << program_name << " -p input.poly                    # Uses 'triangle -pnz'\n";
@@ -84,10 +148,32 @@ void print_usage(const char* program_name) {
     std::cout << "Options:\n";
     std::cout << "  -g, --gpu            Enable GPU acceleration (requires CUDA)\n";
     std::cout << "  -r, --region         Read and process triangulation considering regions\n";
-    std::cout << "  -s, --smooth METHOD  Use smoothing method: laplacian, laplacian-edge-ratio, distmesh\n";
+    std::cout << "  -s, --smooth METHOD  Use smoothing method: laplacian, laplacian-edge-ratio, distmesh, laplacian-cg\n";
     std::cout << "  -i, --iterations N   Number of smoothing iterations (default: 50)\n";
     std::cout << "  -t, --target-length N Target edge length for distmesh method\n";
-    std::cout << "  -O, --output FORMAT  Specify output format: off (default)\n";
+    std::cout << "      --validate-moves Undo laplacian-cg moves that generate intersecting edges\n";
+    std::cout << "      --quality        Evaluate polygon quality measures and add them to the JSON stats\n";
+    std::cout << "      --kernel         Compute the kernel of each polygon and write OUTPUT.kernel\n";
+    std::cout << "      --trace FILE     Write a Chrome trace-event JSON with the time of each phase\n";
+    std::cout << "      --size N         Approximate number of triangles of --generate (default: 100000)\n";
+    std::cout << "      --tip-degree K   Triangles around each barrier-edge tip of fans and spirals (default: 16)\n";
+    std::cout << "      --tip-density D  Fraction of the sites of fans and spirals with a tip, in (0, 1] (default: 1)\n";
+    std::cout << "      --seed N         Seed of the generated input, 0 or more (default: 42)\n";
+    std::cout << "      --reorder CURVE  Renumber the input along a space-filling curve (hilbert or morton) before\n";
+    std::cout << "                       building the polygons, to improve memory locality\n";
+    std::cout << "      --restore-order  With --reorder, write the output vertices in the order of the input\n";
+    std::cout << "      --sort-polygons CURVE Write the polygons in the order of their centroids along a\n";
+    std::cout << "                       space-filling curve (hilbert or morton), for solvers and partitioners\n";
+    std::cout << "      --storage MODE   Backing of the vertex and half-edge arrays: heap (default), hugepages\n";
+    std::cout << "                       (transparent huge pages) or file (mmap of a temporary file)\n";
+    std::cout << "      --storage-dir DIR Directory of the file storage (default: $TMPDIR or /tmp)\n";
+    std::cout << "      --pin MODE       Pin the OpenMP threads: none (default), cores (one core per thread) or\n";
+    std::cout << "                       nodes (the cores of a NUMA node, consecutive threads share a node)\n";
+    std::cout << "      --perf-counters  Add the hardware counters of each phase (cycles, instructions, cache,\n";
+    std::cout << "                       branch and TLB misses) to the JSON stats, requires perf_event_open\n";
+    std::cout << "  -O, --output FORMAT  Specify output format: off (default), vtu (binary VTK), ply (binary PLY)\n";
+    std::cout << "      --stdout         Write the mesh to stdout and the messages to stderr, the JSON stats are\n";
+    std::cout << "                       still written to OUTPUT.json\n";
     std::cout << "  -h, --help           Show this help message\n\n";
     
     // Show CUDA availability status
@@ -98,6 +184,32 @@ void print_usage(const char* program_name) {
 #endif
 }
 
+// Codes for the options that only have a long name
+enum LongOptionCode {
+    OPT_QUALITY = 256,
+    OPT_KERNEL,
+    OPT_TRACE,
+    OPT_PERF_COUNTERS,
+    OPT_GENERATE,
+    OPT_SIZE,
+    OPT_TIP_DEGREE,
+    OPT_TIP_DENSITY,
+    OPT_SEED,
+    OPT_REORDER,
+    OPT_RESTORE_ORDER,
+    OPT_SORT_POLYGONS,
+    OPT_STORAGE,
+    OPT_STORAGE_DIR,
+    OPT_PIN,
+    OPT_BATCH,
+    OPT_SWEEP,
+    OPT_SERVE,
+    OPT_JOBS,
+    OPT_STDOUT,
+    OPT_PIPELINED_READ,
+    OPT_SERVE_MAX_TRIANGLES
+};
+
 bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
     // First pass: check for -p:args format before using getopt
     for (int i = 1; i < argc; i++) {
@@ -131,6 +243,29 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
         {"iterations",    required_argument, 0, 'i'},
         {"target-length", required_argument, 0, 't'},
         {"output",        required_argument, 0, 'O'},
+        {"validate-moves", no_argument,      0, 'V'},
+        {"quality",       no_argument,       0, OPT_QUALITY},
+        {"kernel",        no_argument,       0, OPT_KERNEL},
+        {"trace",         required_argument, 0, OPT_TRACE},
+        {"perf-counters", no_argument,       0, OPT_PERF_COUNTERS},
+        {"generate",      required_argument, 0, OPT_GENERATE},
+        {"size",          required_argument, 0, OPT_SIZE},
+        {"tip-degree",    required_argument, 0, OPT_TIP_DEGREE},
+        {"tip-density",   required_argument, 0, OPT_TIP_DENSITY},
+        {"seed",          required_argument, 0, OPT_SEED},
+        {"reorder",       required_argument, 0, OPT_REORDER},
+        {"restore-order", no_argument,       0, OPT_RESTORE_ORDER},
+        {"sort-polygons", required_argument, 0, OPT_SORT_POLYGONS},
+        {"storage",       required_argument, 0, OPT_STORAGE},
+        {"storage-dir",   required_argument, 0, OPT_STORAGE_DIR},
+        {"pin",           required_argument, 0, OPT_PIN},
+        {"batch",         required_argument, 0, OPT_BATCH},
+        {"sweep",         required_argument, 0, OPT_SWEEP},
+        {"serve",         required_argument, 0, OPT_SERVE},
+        {"serve-max-triangles", required_argument, 0, OPT_SERVE_MAX_TRIANGLES},
+        {"jobs",          required_argument, 0, OPT_JOBS},
+        {"stdout",        no_argument,       0, OPT_STDOUT},
+        {"pipelined-read", no_argument,      0, OPT_PIPELINED_READ},
         {"help",          no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
@@ -138,7 +273,7 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
     int option_index = 0;
     int c;
     
-    while ((c = getopt_long(argc, argv, "onegprs:i:t:O:h", long_options, &option_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "onegprs:i:t:O:Vh", long_options, &option_index)) != -1) {
         switch (c) {
             case 'o':
                 if (options.input_type != ProgramOptions::NONE) {
@@ -183,12 +318,12 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
             case 's':
                 {
                     std::string method = optarg;
-                    std::vector<std::string> valid_methods = {"laplacian", "laplacian-edge-ratio", "distmesh"};
+                    std::vector<std::string> valid_methods = {"laplacian", "laplacian-edge-ratio", "distmesh", "laplacian-cg"};
                     if (std::find(valid_methods.begin(), valid_methods.end(), method) != valid_methods.end()) {
                         options.polylla_options.smooth_method = method;
                     } else {
                         std::cerr << "Error: Invalid smoothing method '" << method << "'\n";
-                        std::cerr << "Valid methods: laplacian, laplacian-edge-ratio, distmesh\n";
+                        std::cerr << "Valid methods: laplacian, laplacian-edge-ratio, distmesh, laplacian-cg\n";
                         return false;
                     }
                 }
@@ -223,10 +358,163 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
                     std::string format = optarg;
                     if (format == "off") {
                         options.output_format = ProgramOptions::OFF_FORMAT;
+                    } else if (format == "vtu") {
+                        options.output_format = ProgramOptions::VTU_FORMAT;
+                    } else if (format == "ply") {
+                        options.output_format = ProgramOptions::PLY_FORMAT;
+                    } else {
+                        std::cerr << "Error: Unknown output format '" << format << "'. Supported: off, vtu, ply" << std::endl;
+                        return false;
+                    }
+                }
+                break;
+                
+            case 'V':
+                options.polylla_options.validate_moves = true;
+                break;
+                
+            case OPT_QUALITY:
+                options.polylla_options.compute_quality = true;
+                break;
+                
+            case OPT_KERNEL:
+                options.polylla_options.compute_kernels = true;
+                break;
+                
+            case OPT_TRACE:
+                options.trace_file = optarg;
+                break;
+                
+            case OPT_PERF_COUNTERS:
+                options.perf_counters = true;
+                break;
+                
+            case OPT_REORDER:
+            case OPT_SORT_POLYGONS:
+                {
+                    std::string curve = optarg;
+                    try {
+                        parse_curve(curve);
+                    } catch (const std::invalid_argument& e) {
+                        std::cerr << "Error: " << e.what() << std::endl;
+                        return false;
+                    }
+                    if (c == OPT_REORDER) options.polylla_options.reorder = curve;
+                    else options.polylla_options.sort_polygons = curve;
+                }
+                break;
+                
+            case OPT_STORAGE:
+                try {
+                    parse_storage(optarg);
+                } catch (const std::invalid_argument& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    return false;
+                }
+                options.storage = optarg;
+                break;
+                
+            case OPT_STORAGE_DIR:
+                options.storage_dir = optarg;
+                break;
+                
+            case OPT_PIN:
+                try {
+                    parse_pin(optarg);
+                } catch (const std::invalid_argument& e) {
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    return false;
+                }
+                options.pin = optarg;
+                break;
+                
+            case OPT_STDOUT:
+                options.to_stdout = true;
+                break;
+
+            case OPT_PIPELINED_READ:
+                options.polylla_options.pipelined_read = true;
+                break;
+                
+            case OPT_BATCH:
+                if (options.input_type != ProgramOptions::NONE) {
+                    std::cerr << "Error: Multiple input types specified\n";
+                    return false;
+                }
+                options.input_type = ProgramOptions::BATCH;
+                options.batch_file = optarg;
+                break;
+                
+            case OPT_SWEEP:
+                options.sweep_file = optarg;
+                break;
+                
+            case OPT_SERVE:
+                if (options.input_type != ProgramOptions::NONE) {
+                    std::cerr << "Error: Multiple input types specified\n";
+                    return false;
+                }
+                options.input_type = ProgramOptions::SERVE;
+                options.serve_socket = optarg;
+                break;
+                
+            case OPT_JOBS:
+                {
+                    std::string jobs_str = optarg;
+                    if (is_positive_num(jobs_str) && jobs_str.size() < 6 && std::stoi(jobs_str) > 0) {
+                        options.batch_jobs = std::stoi(jobs_str);
                     } else {
-                        std::cerr << "Error: Unknown output format '" << format << "'. Supported: off" << std::endl;
+                        std::cerr << "Error: Invalid value '" << jobs_str << "' for jobs. Must be a positive number.\n";
+                        return false;
+                    }
+                }
+                break;
+                
+            case OPT_RESTORE_ORDER:
+                options.polylla_options.restore_vertex_order = true;
+                break;
+                
+            case OPT_GENERATE:
+                {
+                    if (options.input_type != ProgramOptions::NONE) {
+                        std::cerr << "Error: Multiple input types specified\n";
+                        return false;
+                    }
+                    std::string workload = optarg;
+                    std::vector<std::string> valid_workloads = {"grid", "random", "pslg", "fans", "spirals"};
+                    if (std::find(valid_workloads.begin(), valid_workloads.end(), workload) == valid_workloads.end()) {
+                        std::cerr << "Error: Invalid workload '" << workload << "'\n";
+                        std::cerr << "Valid workloads: grid, random, pslg, fans, spirals\n";
                         return false;
                     }
+                    options.input_type = ProgramOptions::GENERATE;
+                    options.workload = workload;
+                }
+                break;
+                
+            case OPT_SIZE:
+            case OPT_TIP_DEGREE:
+            case OPT_TIP_DENSITY:
+            case OPT_SEED:
+            case OPT_SERVE_MAX_TRIANGLES:
+                {
+                    std::string value_str = optarg;
+                    double value = 0;
+                    try {
+                        value = std::stod(value_str);
+                    } catch (const std::exception&) {
+                        value = -1;
+                    }
+                    if (c == OPT_SEED ? value < 0 : value <= 0) {
+                        std::cerr << "Error: Invalid value '" << value_str << "' for " << long_options[option_index].name
+                                  << (c == OPT_SEED ? ". Must be 0 or more.\n" : ". Must be a positive number.\n");
+                        return false;
+                    }
+                    if (c == OPT_SIZE) options.workload_size = static_cast<long long>(value);
+                    else if (c == OPT_TIP_DEGREE) options.workload_tips.tip_degree = static_cast<int>(value);
+                    else if (c == OPT_TIP_DENSITY) options.workload_tips.tip_density = value;
+                    else if (c == OPT_SERVE_MAX_TRIANGLES) options.serve_max_triangles = static_cast<long long>(std::min(value, 1e15));
+                    else options.workload_seed = static_cast<unsigned int>(value);
                 }
                 break;
                 
@@ -255,6 +543,20 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
         return false;
     }
     
+    // "-" reads the input from stdin, the sections of --neigh and --ele one after the other
+    const bool from_stdin = remaining_args.size() == 1 && remaining_args[0] == "-";
+    if (from_stdin && options.input_type == ProgramOptions::OFF) {
+        options.off_file = "-";
+        if (options.output_name.empty()) options.output_name = "stdin_polylla";
+        return true;
+    }
+    if (from_stdin && (options.input_type == ProgramOptions::NEIGH || options.input_type == ProgramOptions::ELE)) {
+        options.node_file = options.ele_file = "-";
+        if (options.input_type == ProgramOptions::NEIGH) options.neigh_file = "-";
+        if (options.output_name.empty()) options.output_name = "stdin";
+        return true;
+    }
+    
     // Process input files based on type
     if (options.input_type == ProgramOptions::OFF) {
         // Look for .off file first (existing behavior)
@@ -366,6 +668,36 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
             std::string base = options.node_file.substr(0, options.node_file.find_last_of("."));
             options.output_name = base;
         }
+    } else if (options.input_type == ProgramOptions::GENERATE) {
+        if (remaining_args.size() > 1) {
+            std::cerr << "Error: --generate takes at most one output name\n";
+            return false;
+        }
+        if (remaining_args.size() == 1 && options.output_name.empty()) {
+            options.output_name = remaining_args[0];
+        }
+        // The options that change the input are part of the name, so the inputs of a manifest have their own outputs
+        if (options.output_name.empty()) {
+            const ProgramOptions defaults;
+            std::ostringstream name;
+            name << options.workload << "_" << options.workload_size;
+            if (options.workload_seed != defaults.workload_seed) name << "_seed" << options.workload_seed;
+            if (options.workload == "fans" || options.workload == "spirals") {
+                if (options.workload_tips.tip_degree != defaults.workload_tips.tip_degree) name << "_k" << options.workload_tips.tip_degree;
+                if (options.workload_tips.tip_density != defaults.workload_tips.tip_density) name << "_d" << options.workload_tips.tip_density;
+            }
+            options.output_name = name.str() + "_polylla";
+        }
+    } else if (options.input_type == ProgramOptions::BATCH) {
+        if (!remaining_args.empty()) {
+            std::cerr << "Error: --batch takes the inputs from the manifest, not from the command line\n";
+            return false;
+        }
+    } else if (options.input_type == ProgramOptions::SERVE || options.input_type == ProgramOptions::ARRAYS) {
+        if (!remaining_args.empty()) {
+            std::cerr << "Error: --serve takes the inputs from its requests, not from the command line\n";
+            return false;
+        }
     } else if (options.input_type == ProgramOptions::POLY) {
         if (remaining_args.size() != 1) {
             std::cerr << "Error: Exactly one .poly file must be specified\n";
@@ -380,7 +712,9 @@ bool parse_arguments(int argc, char** argv, ProgramOptions& options) {
 bool validate_file_extensions(const ProgramOptions& options) {
     // File existence and extension validation
     
-    if (options.input_type == ProgramOptions::OFF) {
+    if (options.off_file == "-" || options.node_file == "-") {
+        // Standard input
+    } else if (options.input_type == ProgramOptions::OFF) {
         if (!file_exists(options.off_file)) {
             std::cerr << "Error: File '" << options.off_file << "' does not exist" << std::endl;
             return false;
@@ -416,15 +750,36 @@ bool validate_file_extensions(const ProgramOptions& options) {
                 return false;
             }
         }
+    } else if (options.input_type == ProgramOptions::BATCH) {
+        if (!file_exists(options.batch_file)) {
+            std::cerr << "Error: File '" << options.batch_file << "' does not exist" << std::endl;
+            return false;
+        }
+        if (!options.sweep_file.empty()) {
+            std::cerr << "Error: --sweep can not be used with --batch" << std::endl;
+            return false;
+        }
+    } else if (options.input_type == ProgramOptions::SERVE) {
+        if (!options.sweep_file.empty()) {
+            std::cerr << "Error: --sweep can not be used with --serve" << std::endl;
+            return false;
+        }
     } else if (options.input_type == ProgramOptions::POLY) {
         if (!file_exists(options.poly_file)) {
             std::cerr << "Error: File '" << options.poly_file << "' does not exist" << std::endl;
             return false;
         }
     }
+    if (!options.sweep_file.empty() && !file_exists(options.sweep_file)) {
+        std::cerr << "Error: File '" << options.sweep_file << "' does not exist" << std::endl;
+        return false;
+    }
     return true;
 }
 
+// Stdout of --stdout, std::cout writes the messages to stderr meanwhile
+std::streambuf* mesh_stdout = nullptr;
+
 // Helper function template to execute common mesh operations
 template<typename MeshType>
 void execute_mesh_operations(MeshType& mesh, const ProgramOptions& options) {
@@ -433,11 +788,55 @@ void execute_mesh_operations(MeshType& mesh, const ProgramOptions& options) {
     std::cout << "output json in " << options.output_name << ".json" << std::endl;
     
     // Generate format-specific output
-    switch (options.output_format) {
+    if (options.to_stdout) {
+        // The binary formats need no seeking, so all of them can be written to a pipe
+        if constexpr (std::is_same<MeshType, Polylla>::value) {
+            std::ostream out(mesh_stdout);
+            const char* format = "off";
+            if (options.output_format == ProgramOptions::VTU_FORMAT) {
+                mesh.print_VTU(out);
+                format = "vtu";
+            } else if (options.output_format == ProgramOptions::PLY_FORMAT) {
+                mesh.print_PLY(out);
+                format = "ply";
+            } else {
+                mesh.print_OFF(out);
+            }
+            if (!out.flush()) {
+                throw std::runtime_error("Unable to write the mesh to stdout");
+            }
+            std::cout << "output " << format << " to stdout" << std::endl;
+        } else {
+            throw std::runtime_error("GPU version does not support --stdout");
+        }
+    } else switch (options.output_format) {
         case ProgramOptions::OFF_FORMAT:
             mesh.print_OFF(options.output_name + ".off");
             std::cout << "output off in " << options.output_name << ".off" << std::endl;
             break;
+        case ProgramOptions::VTU_FORMAT:
+        case ProgramOptions::PLY_FORMAT:
+            // Binary formats are only written by the CPU version
+            if constexpr (std::is_same<MeshType, Polylla>::value) {
+                if (options.output_format == ProgramOptions::VTU_FORMAT) {
+                    mesh.print_VTU(options.output_name + ".vtu");
+                    std::cout << "output vtu in " << options.output_name << ".vtu" << std::endl;
+                } else {
+                    mesh.print_PLY(options.output_name + ".ply");
+                    std::cout << "output ply in " << options.output_name << ".ply" << std::endl;
+                }
+            } else {
+                throw std::runtime_error("GPU version only supports the off output format");
+            }
+            break;
+    }
+
+    // Kernels are only computed by the CPU version
+    if constexpr (std::is_same<MeshType, Polylla>::value) {
+        if (options.polylla_options.compute_kernels) {
+            mesh.print_kernels(options.output_name + ".kernel");
+            std::cout << "output kernel in " << options.output_name << ".kernel" << std::endl;
+        }
     }
 }
 
@@ -510,6 +909,25 @@ void process_ele_files(const ProgramOptions& options) {
     execute_mesh_operations(mesh, options);
 }
 
+// Helper function for generated inputs (CPU only)
+void process_generated_workload(const ProgramOptions& options) {
+#ifdef CUDA_AVAILABLE
+    if (options.use_gpu) {
+        throw std::runtime_error("GPU mode not supported for --generate");
+    }
+#endif
+    std::cout << "Generating " << options.workload << " triangulation with about " << options.workload_size << " triangles" << std::endl;
+    Workload workload;
+    {
+        TraceScope trace("generate_workload");
+        workload = make_workload(options.workload, options.workload_size, options.workload_seed, options.workload_tips);
+    }
+    std::cout << "Generated " << workload.n_triangles() << " triangles and " << workload.n_vertices() << " vertices" << std::endl;
+    
+    Polylla mesh(workload.to_triangulation(), options.polylla_options);
+    execute_mesh_operations(mesh, options);
+}
+
 // Helper function to get triangle executable path relative to Polylla executable
 std::string get_triangle_path() {
     try {
@@ -523,8 +941,8 @@ std::string get_triangle_path() {
     }
 }
 
-// Helper function for POLY file processing
-void process_poly_file(const ProgramOptions& options) {
+// Run Triangle on the .poly file, return the options to read its outputs as NEIGH input
+ProgramOptions triangulate_poly_file(const ProgramOptions& options) {
     // Determine triangle arguments based on region flag
     std::string triangle_args = options.triangle_args;
     if (options.polylla_options.use_regions && triangle_args == "pnz") {
@@ -551,7 +969,11 @@ void process_poly_file(const ProgramOptions& options) {
     std::cout << std::string(80, '-') << std::endl;
     
     // Execute triangle
-    int result = system(triangle_cmd.c_str());
+    int result;
+    {
+        TraceScope trace("triangle");
+        result = system(triangle_cmd.c_str());
+    }
     
     // Visual separation after Triangle execution
     std::cout << std::string(80, '-') << std::endl;
@@ -590,13 +1012,611 @@ void process_poly_file(const ProgramOptions& options) {
     }
     
     std::cout << "Triangle completed successfully. Processing with Polylla..." << std::endl;
-    
-    // Process with Polylla using the generated files
-    process_neigh_files(modified_options);
+    return modified_options;
+}
+
+// Helper function for POLY file processing
+void process_poly_file(const ProgramOptions& options) {
+    // Process with Polylla using the files generated by Triangle
+    process_neigh_files(triangulate_poly_file(options));
+}
+
+// The per-phase memory and counters of the JSON stats are those of the next mesh, not of the previous
+// items, configurations or requests of the process
+void begin_mesh_stats() {
+    MemoryStats::instance().begin_run();
+    PerfCounters::instance().begin_run();
+}
+
+// Run the input of options, the outputs are named after options.output_name
+void process_input(const ProgramOptions& options) {
+    begin_mesh_stats();
+    switch (options.input_type) {
+        case ProgramOptions::OFF:
+            process_off_file(options);
+            break;
+        case ProgramOptions::NEIGH:
+            process_neigh_files(options);
+            break;
+        case ProgramOptions::ELE:
+            process_ele_files(options);
+            break;
+        case ProgramOptions::POLY:
+            process_poly_file(options);
+            break;
+        case ProgramOptions::GENERATE:
+            process_generated_workload(options);
+            break;
+        default:
+            throw std::runtime_error("No valid input type specified");
+    }
+}
+
+// Batch mode: each line of the manifest is an input mode with its files and options, e.g.
+//     --off meshes/a.off
+//     --neigh meshes/b.1.node meshes/b.1.ele meshes/b.1.neigh --smooth laplacian
+// Sweep mode: each line is a configuration of the input of the command line, e.g.
+//     --smooth laplacian --iterations 100
+// The options of the command line are applied to every line. The items run on a pool of worker
+// threads, each with its own Workspace, so the consecutive meshes of a worker reuse their arrays.
+struct batch_item {
+    int line;  // Line of the manifest
+    ProgramOptions options;
+    std::string input;  // First input file or generated workload
+    std::string output;  // Base name of the outputs
+    std::string error;  // Empty if the item succeeded
+    double time = 0;  // ms
+};
+
+// Stream buffer that discards the output of the items while they run
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+std::string json_escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) c = ' ';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Options of the command line that are applied to every item, without --batch, --sweep, --serve and --jobs
+std::vector<std::string> common_batch_arguments(const std::vector<std::string>& command_line) {
+    const std::vector<std::string> modes = {"--batch", "--sweep", "--serve", "--jobs"};
+    std::vector<std::string> arguments;
+    for (std::size_t i = 1; i < command_line.size(); i++) {
+        const std::string& arg = command_line[i];
+        if (std::find(modes.begin(), modes.end(), arg) != modes.end()) {
+            i++;
+        } else if (std::none_of(modes.begin(), modes.end(), [&arg](const std::string& mode) { return arg.compare(0, mode.size() + 1, mode + "=") == 0; })) {
+            arguments.push_back(arg);
+        }
+    }
+    return arguments;
+}
+
+// Parse and validate a manifest line with the options of the command line, the errors are kept in item.error
+// input_type presets the input mode of the line, return false for an empty or a comment line
+// With same_input the line is a configuration of the input of the command line
+bool parse_item_line(const ProgramOptions& options, const std::string& line, batch_item& item,
+                     const ProgramOptions::InputType input_type = ProgramOptions::NONE, const bool same_input = false) {
+    std::vector<std::string> arguments = {"Polylla"};
+    arguments.insert(arguments.end(), options.batch_arguments.begin(), options.batch_arguments.end());
+    std::istringstream fields(line);
+    std::string field;
+    std::size_t n_fields = 0;
+    while (fields >> std::quoted(field)) {
+        if (n_fields == 0 && field[0] == '#') break;
+        arguments.push_back(field);
+        n_fields++;
+    }
+    if (n_fields == 0 && input_type == ProgramOptions::NONE) return false;
+
+    std::vector<char*> argv;
+    for (std::string& arg : arguments) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    item.options.input_type = input_type;
+    const ProgramOptions& item_options = item.options;
+    bool parsed;
+    {
+        // getopt keeps its state in globals, the workers of --serve parse one line at a time
+        static std::mutex getopt_mutex;
+        std::lock_guard<std::mutex> lock(getopt_mutex);
+        optind = 0;  // Restart getopt for each line
+        parsed = parse_arguments(static_cast<int>(arguments.size()), argv.data(), item.options);
+    }
+    if (!parsed || item_options.help) {
+        item.error = "invalid arguments";
+    } else if (item_options.input_type == ProgramOptions::BATCH || item_options.input_type == ProgramOptions::SERVE || !item_options.sweep_file.empty()) {
+        item.error = "--batch, --sweep and --serve can not be nested";
+    } else if (item_options.to_stdout || item_options.off_file == "-" || item_options.node_file == "-") {
+        // The items run concurrently, they can not share the standard streams
+        item.error = "stdin and --stdout can not be used with --batch, --sweep and --serve";
+    } else if (item_options.use_gpu || item_options.pin != "none" || item_options.perf_counters) {
+        item.error = "--gpu, --pin and --perf-counters are not supported with --batch, --sweep and --serve";
+    } else if (item_options.storage != options.storage || item_options.storage_dir != options.storage_dir ||
+               item_options.trace_file != options.trace_file) {
+        // The storage and tracing are shared by the whole process
+        item.error = "--storage, --storage-dir and --trace are only accepted on the command line";
+    } else if (same_input && item_options.polylla_options.use_regions != options.polylla_options.use_regions) {
+        // The input is read once, with the regions of the command line
+        item.error = "--region is only accepted on the command line";
+    } else if (!validate_file_extensions(item_options) || !validate_polylla_options(item_options.polylla_options)) {
+        item.error = "invalid input or options";
+    }
+
+    switch (item_options.input_type) {
+        case ProgramOptions::OFF: item.input = item_options.off_file; break;
+        case ProgramOptions::NEIGH:
+        case ProgramOptions::ELE: item.input = item_options.node_file; break;
+        case ProgramOptions::POLY: item.input = item_options.poly_file; break;
+        case ProgramOptions::GENERATE: item.input = item_options.workload; break;
+        default: item.input = line;
+    }
+    // The outputs of a .poly input are named by process_poly_file
+    item.output = item_options.output_name;
+    if (item_options.input_type == ProgramOptions::POLY && item.output.empty()) {
+        item.output = item.input.substr(0, item.input.size() - (item.input.size() > 5 && item.input.substr(item.input.size() - 5) == ".poly" ? 5 : 0));
+    }
+    return true;
+}
+
+// Parse and validate every line of the manifest, the invalid lines are kept as failed items
+// With a sweep_output the items are configurations of the same input, the outputs of the k-th are sweep_output_k
+std::vector<batch_item> read_manifest(const ProgramOptions& options, const std::string& manifest_file, const std::string& sweep_output = "") {
+    std::ifstream manifest(manifest_file);
+    if (!manifest.is_open()) {
+        throw std::runtime_error("Unable to open manifest " + manifest_file);
+    }
+    std::vector<batch_item> items;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(manifest, line)) {
+        line_number++;
+        batch_item item;
+        item.line = line_number;
+        if (!parse_item_line(options, line, item, ProgramOptions::NONE, !sweep_output.empty())) continue;
+        if (!sweep_output.empty()) {
+            item.input = line;
+            item.output = item.options.output_name = sweep_output + "_" + std::to_string(items.size() + 1);
+        }
+        if (!item.error.empty()) {
+            std::cerr << "  in line " << line_number << " of " << manifest_file << std::endl;
+        } else {
+            // Two workers writing the same files would mix their outputs
+            for (const batch_item& previous : items) {
+                if (previous.error.empty() && previous.output == item.output) {
+                    item.error = "same outputs as line " + std::to_string(previous.line);
+                    break;
+                }
+            }
+        }
+        items.push_back(item);
+    }
+    return items;
+}
+
+// Workers of a batch and their share of the OpenMP threads
+struct batch_pool {
+    int workers;
+    int threads_per_worker;
+    double time_total = 0;  // ms
+};
+
+batch_pool make_batch_pool(const ProgramOptions& options, const std::size_t n_items) {
+    int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    const int jobs = options.batch_jobs > 0 ? options.batch_jobs : max_threads;
+    batch_pool pool;
+    pool.threads_per_worker = std::max(1, max_threads / jobs);
+    pool.workers = static_cast<int>(std::max<std::size_t>(1, std::min<std::size_t>(jobs, n_items)));
+    return pool;
+}
+
+// Run run_item on the valid items with the workers of the pool, the errors of the items are recorded
+template <typename RunItem>
+void run_batch_items(std::vector<batch_item>& items, batch_pool& pool, RunItem run_item) {
+    // The progress is written to the original stdout, the output of the items is discarded
+    NullBuffer null_buffer;
+    std::streambuf* cout_buffer = std::cout.rdbuf();
+    std::ostream progress(cout_buffer);
+    std::cout.rdbuf(&null_buffer);
+
+    std::atomic<std::size_t> next_item(0);
+    std::mutex progress_mutex;
+    std::size_t n_done = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    auto worker = [&]() {
+#ifdef _OPENMP
+        omp_set_num_threads(pool.threads_per_worker);
+#endif
+        Workspace workspace;
+        WorkspaceScope scope(workspace);
+        for (std::size_t i = next_item++; i < items.size(); i = next_item++) {
+            batch_item& item = items[i];
+            if (item.error.empty()) {
+                auto t_item = std::chrono::high_resolution_clock::now();
+                try {
+                    run_item(item);
+                } catch (const std::exception& e) {
+                    item.error = e.what();
+                }
+                item.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_item).count();
+            }
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            n_done++;
+            progress << "[" << n_done << "/" << items.size() << "] " << item.input;
+            if (item.error.empty()) progress << " in " << item.time << " ms" << std::endl;
+            else progress << " failed: " << item.error << std::endl;
+        }
+    };
+    // The items of several workers share the heap counters of malloc_count
+    MemoryStats::instance().set_concurrent(pool.workers > 1);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < pool.workers; w++) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    MemoryStats::instance().set_concurrent(false);
+    pool.time_total = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+    std::cout.rdbuf(cout_buffer);
+}
+
+// Write the pool and the result of every item to out, after the fields of the mode, return the failed items
+std::size_t write_batch_results(std::ofstream& out, const std::vector<batch_item>& items, const batch_pool& pool) {
+    std::size_t n_failed = 0;
+    for (const batch_item& item : items) {
+        if (!item.error.empty()) n_failed++;
+    }
+    out<<"\"workers\": "<<pool.workers<<","<<std::endl;
+    out<<"\"threads_per_worker\": "<<pool.threads_per_worker<<","<<std::endl;
+    out<<"\"items\": "<<items.size()<<","<<std::endl;
+    out<<"\"succeeded\": "<<items.size() - n_failed<<","<<std::endl;
+    out<<"\"failed\": "<<n_failed<<","<<std::endl;
+    out<<"\"time_total\": "<<pool.time_total<<","<<std::endl;
+    out<<"\"items_per_second\": "<<(pool.time_total > 0 ? items.size() / (pool.time_total / 1000) : 0)<<","<<std::endl;
+    out<<"\"results\": ["<<std::endl;
+    for (std::size_t i = 0; i < items.size(); i++) {
+        const batch_item& item = items[i];
+        out<<"{\"line\": "<<item.line<<", \"input\": \""<<json_escape(item.input)<<"\", \"output\": \""<<json_escape(item.output)
+           <<"\", \"status\": \""<<(item.error.empty() ? "ok" : "failed")<<"\", \"time\": "<<item.time;
+        if (!item.error.empty()) out<<", \"error\": \""<<json_escape(item.error)<<"\"";
+        out<<"}"<<(i + 1 < items.size() ? "," : "")<<std::endl;
+    }
+    out<<"]"<<std::endl;
+    out<<"}"<<std::endl;
+    std::cout << "Processed " << items.size() - n_failed << " of " << items.size() << " items in " << pool.time_total << " ms" << std::endl;
+    return n_failed;
+}
+
+// FILE_<mode>.json next to the manifest
+std::string batch_summary_file(const std::string& manifest_file, const std::string& mode) {
+    std::filesystem::path summary_path = manifest_file;
+    summary_path.replace_extension();
+    return summary_path.string() + "_" + mode + ".json";
+}
+
+// Process the items of the manifest on a pool of worker threads and write the summary,
+// return false if an item failed
+bool process_batch(const ProgramOptions& options) {
+    std::vector<batch_item> items = read_manifest(options, options.batch_file);
+    batch_pool pool = make_batch_pool(options, items.size());
+    std::cout << "Processing " << items.size() << " items of " << options.batch_file << " with " << pool.workers
+              << " workers of " << pool.threads_per_worker << " threads" << std::endl;
+
+    run_batch_items(items, pool, [](const batch_item& item) { process_input(item.options); });
+
+    const std::string summary_file = batch_summary_file(options.batch_file, "batch");
+    std::ofstream out(summary_file);
+    out<<"{"<<std::endl;
+    out<<"\"manifest\": \""<<json_escape(options.batch_file)<<"\","<<std::endl;
+    const std::size_t n_failed = write_batch_results(out, items, pool);
+    out.close();
+    std::cout << "output batch summary in " << summary_file << std::endl;
+    return n_failed == 0;
+}
+
+// Read the input of the command line once and run every configuration of the sweep file on a copy of it,
+// return false if a configuration failed
+bool process_sweep(const ProgramOptions& options) {
+    // The outputs of Triangle are read as NEIGH input
+    ProgramOptions input_options = options.input_type == ProgramOptions::POLY ? triangulate_poly_file(options) : options;
+    if (input_options.use_gpu) {
+        throw std::runtime_error("GPU mode not supported for --sweep");
+    }
+    std::vector<batch_item> items = read_manifest(options, options.sweep_file, input_options.output_name);
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    Workload workload;
+    std::unique_ptr<Triangulation> mesh;
+    const bool use_regions = input_options.polylla_options.use_regions;
+    switch (input_options.input_type) {
+        case ProgramOptions::OFF:
+            mesh.reset(new Triangulation(input_options.off_file, use_regions));
+            break;
+        case ProgramOptions::NEIGH:
+            mesh.reset(new Triangulation(input_options.node_file, input_options.ele_file, input_options.neigh_file, use_regions));
+            break;
+        case ProgramOptions::ELE:
+            mesh.reset(new Triangulation(input_options.node_file, input_options.ele_file, use_regions));
+            break;
+        case ProgramOptions::GENERATE:
+            workload = make_workload(input_options.workload, input_options.workload_size, input_options.workload_seed, input_options.workload_tips);
+            mesh.reset(workload.to_triangulation());
+            break;
+        default:
+            throw std::runtime_error("No valid input type specified");
+    }
+    const double t_load = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+
+    batch_pool pool = make_batch_pool(options, items.size());
+    std::cout << "Loaded " << mesh->faces() << " triangles in " << t_load << " ms, running " << items.size()
+              << " configurations with " << pool.workers << " workers of " << pool.threads_per_worker << " threads" << std::endl;
+
+    // Each configuration takes a copy of the loaded triangulation, Polylla smooths and owns the copy
+    const Triangulation& loaded = *mesh;
+    run_batch_items(items, pool, [&loaded](const batch_item& item) {
+        begin_mesh_stats();
+        Polylla polylla(new Triangulation(loaded), item.options.polylla_options);
+        execute_mesh_operations(polylla, item.options);
+    });
+
+    const std::string summary_file = batch_summary_file(options.sweep_file, "sweep");
+    std::ofstream out(summary_file);
+    out<<"{"<<std::endl;
+    out<<"\"sweep\": \""<<json_escape(options.sweep_file)<<"\","<<std::endl;
+    out<<"\"output\": \""<<json_escape(input_options.output_name)<<"\","<<std::endl;
+    out<<"\"time_to_load\": "<<t_load<<","<<std::endl;
+    const std::size_t n_failed = write_batch_results(out, items, pool);
+    out.close();
+    std::cout << "output sweep summary in " << summary_file << std::endl;
+    return n_failed == 0;
+}
+
+// Serve mode: the requests of serve_protocol.hpp are read from the connections of a Unix socket.
+// The connections are served by a pool of workers, each with its own Workspace and input arrays,
+// so the arrays of the meshes of a worker stay allocated between its requests.
+static std::atomic<bool> serve_stop(false);
+
+extern "C" void stop_serving(int) {
+    serve_stop = true;
+}
+
+// Input arrays of the mesh requests, reused by the requests of a worker
+struct serve_buffers {
+    std::vector<double> xy;
+    std::vector<int32_t> tri, neigh, regions;
+    std::vector<int32_t> polygon_vertices;
+    std::vector<double> polygon_xy;
+};
+
+template <typename T>
+bool read_array(SocketReader& reader, std::vector<T>& values, const std::size_t n) {
+    values.resize(n);
+    return reader.read(values.data(), n * sizeof(T));
+}
+
+template <typename T>
+bool write_array(const int fd, const T* values, const std::size_t n) {
+    return write_all(fd, values, n * sizeof(T));
+}
+
+// Run a mesh request, the triangulation has been read into buffers
+bool serve_mesh(const int fd, const ProgramOptions& options, const std::string& arguments, const int32_t nv, const int32_t nt,
+                const int flags, serve_buffers& buffers, std::string& error) {
+    batch_item item;
+    parse_item_line(options, arguments, item, ProgramOptions::ARRAYS);
+    const PolyllaOptions& polylla_options = item.options.polylla_options;
+    if (item.error.empty() && polylla_options.use_regions && !(flags & MESH_REGIONS)) {
+        item.error = "--region requires the regions array";
+    }
+    if (!item.error.empty()) {
+        error = item.error;
+        return write_line(fd, "error " + error);
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    begin_mesh_stats();
+    Polylla polylla(new Triangulation(buffers.xy.data(), nv, buffers.tri.data(), nt,
+                                      (flags & MESH_NEIGH) ? buffers.neigh.data() : nullptr,
+                                      polylla_options.use_regions ? buffers.regions.data() : nullptr),
+                    polylla_options);
+    const PolygonMesh polygons = polylla.get_polygon_mesh();
+    const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+
+    // The vertices of the wire are int32 in every build, the inline meshes have less than 2^31 vertices
+    buffers.polygon_vertices.assign(polygons.polygon_vertices.begin(), polygons.polygon_vertices.end());
+    const CoordinatesView& coordinates = polygons.coordinates;
+    buffers.polygon_xy.resize(2 * static_cast<std::size_t>(coordinates.n_vertices));
+    for (index_t v = 0; v < coordinates.n_vertices; v++) {
+        buffers.polygon_xy[2*v] = coordinates.X(v);
+        buffers.polygon_xy[2*v+1] = coordinates.Y(v);
+    }
+    const int reply_flags = polygons.polygon_region.empty() ? 0 : MESH_REGIONS;
+    std::ostringstream reply;
+    reply << "ok " << polygons.n_polygons() << " " << coordinates.n_vertices << " " << buffers.polygon_vertices.size()
+          << " " << reply_flags << " " << time;
+    static_assert(sizeof(long long) == sizeof(int64_t), "polygon offsets are sent as int64");
+    return write_line(fd, reply.str()) &&
+           write_array(fd, polygons.polygon_offsets.data(), polygons.polygon_offsets.size()) &&
+           write_array(fd, buffers.polygon_vertices.data(), buffers.polygon_vertices.size()) &&
+           write_array(fd, buffers.polygon_xy.data(), buffers.polygon_xy.size()) &&
+           (reply_flags == 0 || write_array(fd, polygons.polygon_region.data(), polygons.polygon_region.size()));
+}
+
+// Serve the requests of a connection until it is closed, a shutdown request or the server stops
+void serve_connection(const int fd, const ProgramOptions& options, serve_buffers& buffers, std::ostream& progress,
+                      std::mutex& progress_mutex, std::atomic<std::size_t>& n_requests) {
+    SocketReader reader(fd);
+    std::string line;
+    while (!serve_stop) {
+        // Wait for the next request, waking up to see if the server stops
+        if (!reader.buffered()) {
+            pollfd request = {fd, POLLIN, 0};
+            const int ready = poll(&request, 1, 200);
+            if (ready == 0 || (ready < 0 && errno == EINTR)) continue;
+            if (ready < 0) return;
+        }
+        if (!reader.read_line(line)) return;
+        std::istringstream fields(line);
+        std::string command;
+        fields >> command;
+        std::string arguments;
+        std::getline(fields >> std::ws, arguments);
+
+        auto t_start = std::chrono::high_resolution_clock::now();
+        std::string error;
+        bool connected = true, replied = false, reading_arrays = false;
+        try {
+            if (command == "run") {
+                batch_item item;
+                parse_item_line(options, arguments, item);
+                if (item.error.empty()) {
+                    process_input(item.options);
+                    const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+                    connected = write_line(fd, "ok " + std::to_string(time) + " " + item.output);
+                } else {
+                    error = item.error;
+                }
+            } else if (command == "mesh") {
+                std::istringstream header(arguments);
+                long long nv = 0, nt = 0;
+                int flags = 0;
+                if (!(header >> nv >> nt >> flags) || nv < 3 || nt < 1 || nv > INT32_MAX || 3 * nt > INT32_MAX) {
+                    // The size of the arrays that follow is unknown, the connection can not continue
+                    write_line(fd, "error invalid mesh header");
+                    return;
+                }
+                if (nt > options.serve_max_triangles || nv > 3 * options.serve_max_triangles) {
+                    // The arrays are allocated before they arrive, the size declared by the client is bounded
+                    write_line(fd, "error mesh larger than --serve-max-triangles " + std::to_string(options.serve_max_triangles));
+                    return;
+                }
+                std::string mesh_arguments;
+                std::getline(header >> std::ws, mesh_arguments);
+                reading_arrays = true;
+                connected = read_array(reader, buffers.xy, 2 * nv) && read_array(reader, buffers.tri, 3 * nt) &&
+                            (!(flags & MESH_NEIGH) || read_array(reader, buffers.neigh, 3 * nt)) &&
+                            (!(flags & MESH_REGIONS) || read_array(reader, buffers.regions, nt));
+                reading_arrays = false;
+                connected = connected &&
+                            serve_mesh(fd, options, mesh_arguments, static_cast<int32_t>(nv), static_cast<int32_t>(nt), flags, buffers, error);
+                replied = true;
+            } else if (command == "shutdown") {
+                serve_stop = true;
+                write_line(fd, "ok 0 shutdown");
+                return;
+            } else {
+                error = "unknown request '" + command + "'";
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+            replied = false;
+        }
+        if (!error.empty() && !replied) {
+            std::replace(error.begin(), error.end(), '\n', ' ');
+            connected = write_line(fd, "error " + error);
+            // The rest of the arrays of a failed mesh request is unread, the connection can not continue
+            if (reading_arrays) connected = false;
+        }
+        const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            progress << "[" << ++n_requests << "] " << command << " " << arguments;
+            if (error.empty()) progress << " in " << time << " ms" << std::endl;
+            else progress << " failed: " << error << std::endl;
+        }
+        if (!connected) return;
+    }
+}
+
+// Accept connections on the socket and serve them on the worker pool until a shutdown request, SIGINT or SIGTERM
+void process_serve(const ProgramOptions& options) {
+    const int listen_fd = listen_unix(options.serve_socket);
+    serve_stop = false;
+    std::signal(SIGINT, stop_serving);
+    std::signal(SIGTERM, stop_serving);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // A connection holds a worker until it is closed
+    batch_pool pool = make_batch_pool(options, static_cast<std::size_t>(-1));
+    std::cout << "Serving on " << options.serve_socket << " with " << pool.workers << " workers of "
+              << pool.threads_per_worker << " threads" << std::endl;
+
+    NullBuffer null_buffer;
+    std::streambuf* cout_buffer = std::cout.rdbuf();
+    std::ostream progress(cout_buffer);
+    std::cout.rdbuf(&null_buffer);
+
+    std::deque<int> connections;
+    std::mutex connections_mutex, progress_mutex;
+    std::condition_variable connection_ready;
+    std::atomic<std::size_t> n_requests(0);
+    auto worker = [&]() {
+#ifdef _OPENMP
+        omp_set_num_threads(pool.threads_per_worker);
+#endif
+        Workspace workspace;
+        WorkspaceScope scope(workspace);
+        serve_buffers buffers;
+        while (true) {
+            int fd;
+            {
+                std::unique_lock<std::mutex> lock(connections_mutex);
+                connection_ready.wait(lock, [&]() { return serve_stop || !connections.empty(); });
+                if (connections.empty()) return;
+                fd = connections.front();
+                connections.pop_front();
+            }
+            serve_connection(fd, options, buffers, progress, progress_mutex, n_requests);
+            close(fd);
+        }
+    };
+    MemoryStats::instance().set_concurrent(pool.workers > 1);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < pool.workers; w++) {
+        workers.emplace_back(worker);
+    }
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    while (!serve_stop) {
+        pollfd listening = {listen_fd, POLLIN, 0};
+        if (poll(&listening, 1, 200) <= 0) continue;
+        const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        connections.push_back(fd);
+        connection_ready.notify_one();
+    }
+    {
+        // The queued connections are served before the workers stop
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        connection_ready.notify_all();
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    MemoryStats::instance().set_concurrent(false);
+    close(listen_fd);
+    unlink(options.serve_socket.c_str());
+    std::cout.rdbuf(cout_buffer);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+    std::cout << "Served " << n_requests << " requests in " << time << " ms" << std::endl;
 }
 
 int main(int argc, char **argv) {
     ProgramOptions options;
+    const std::vector<std::string> command_line(argv, argv + argc);  // parse_arguments reorders argv
     
     if (!parse_arguments(argc, argv, options)) {
         print_usage(argv[0]);
@@ -628,6 +1648,33 @@ int main(int argc, char **argv) {
         return 1;
     }
     
+    if (options.input_type == ProgramOptions::BATCH || options.input_type == ProgramOptions::SERVE || !options.sweep_file.empty()) {
+        // The workers share the cores, pinning the OpenMP threads of one of them would not help,
+        // and the counters are opened on the OpenMP threads of the main thread, not on those of the workers
+        if (options.use_gpu || options.pin != "none" || options.perf_counters) {
+            std::cerr << "Error: --gpu, --pin and --perf-counters are not supported with --batch, --sweep and --serve" << std::endl;
+            return 1;
+        }
+        if (options.to_stdout) {
+            std::cerr << "Error: --stdout is not supported with --batch, --sweep and --serve" << std::endl;
+            return 1;
+        }
+        options.batch_arguments = common_batch_arguments(command_line);
+    }
+    
+    // The streams are not synchronized with stdio, std::cin reads the input in large blocks
+    if (options.off_file == "-" || options.node_file == "-" || options.to_stdout) {
+        std::ios::sync_with_stdio(false);
+    }
+    if (options.to_stdout) {
+        if (options.use_gpu) {
+            std::cerr << "Error: --stdout is not supported with --gpu" << std::endl;
+            return 1;
+        }
+        mesh_stdout = std::cout.rdbuf();
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    
     // Print configuration if regions or smoothing are enabled
     if (options.polylla_options.use_regions) {
         std::cout << "Region reading and verification enabled" << std::endl;
@@ -640,28 +1687,43 @@ int main(int argc, char **argv) {
         }
     }
     
+    if (!options.trace_file.empty()) {
+        Tracer::instance().enable();
+    }
+    
+    ArrayStorage::instance().set_mode(parse_storage(options.storage), options.storage_dir);
+    if (options.storage != "heap") {
+        std::cout << "Vertex and half-edge arrays backed by " << options.storage << " storage" << std::endl;
+    }
+    
+    // Pin before reading the input, the arrays are first touched by the pinned threads
+    if (!NumaPlacement::instance().pin_threads(parse_pin(options.pin))) {
+        std::cout << "Thread pinning unavailable (" << NumaPlacement::instance().error()
+                  << "), running without it" << std::endl;
+    } else if (options.pin != "none") {
+        std::cout << "OpenMP threads pinned to " << options.pin << " of "
+                  << NumaPlacement::node_cpus().size() << " NUMA node(s)" << std::endl;
+    }
+    
+    if (options.perf_counters && !PerfCounters::instance().enable()) {
+        std::cout << "Performance counters unavailable (" << PerfCounters::instance().open_error()
+                  << "), running without them" << std::endl;
+    }
+    
     try {
         // Process mesh based on input type and GPU selection
-        switch (options.input_type) {
-            case ProgramOptions::OFF:
-                process_off_file(options);
-                break;
-                
-            case ProgramOptions::NEIGH:
-                process_neigh_files(options);
-                break;
-                
-            case ProgramOptions::ELE:
-                process_ele_files(options);
-                break;
-                
-            case ProgramOptions::POLY:
-                process_poly_file(options);
-                break;
-                
-            default:
-                std::cerr << "Error: No valid input type specified" << std::endl;
+        if (options.input_type == ProgramOptions::BATCH) {
+            if (!process_batch(options)) {
+                return 1;
+            }
+        } else if (!options.sweep_file.empty()) {
+            if (!process_sweep(options)) {
                 return 1;
+            }
+        } else if (options.input_type == ProgramOptions::SERVE) {
+            process_serve(options);
+        } else {
+            process_input(options);
         }
         
         // Uncomment when ALE output is needed
@@ -672,5 +1734,10 @@ int main(int argc, char **argv) {
         return 1;
     }
     
+    if (!options.trace_file.empty()) {
+        Tracer::instance().write(options.trace_file);
+        std::cout << "output trace in " << options.trace_file << std::endl;
+    }
+    
     return 0;
 }
@@ -0,0 +1,112 @@
+// Buffered text writer used by the mesh output files.
+// Items (vertices, polygons, ...) are formatted in parallel, in chunks, into per-thread
+// buffers and the buffers are written in order with large sequential writes, so the
+// output is the same as writing the items one by one.
+/*
+Basic operations
+    TextBuffer: append integers, doubles (printf "%.15g" format, same as std::setprecision(15)) and text,
+                append_binary(value) appends the little-endian bytes of a number for the binary formats
+    write_parallel(out, n, format_item): call format_item(buffer, i) for i in [0, n) in parallel and write the result in order
+*/
+
+#ifndef BUFFERED_WRITER_HPP
+#define BUFFERED_WRITER_HPP
+
+#include <charconv>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <trace.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class TextBuffer {
+private:
+    std::string data;
+
+    template <typename T>
+    void append_integer(const T value) {
+        char tmp[32];
+        std::to_chars_result res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+        data.append(tmp, res.ptr - tmp);
+    }
+
+    template <typename T>
+    void append_floating(const T value) {
+        char tmp[64];
+        std::to_chars_result res = std::to_chars(tmp, tmp + sizeof(tmp), value, std::chars_format::general, PRECISION);
+        data.append(tmp, res.ptr - tmp);
+    }
+
+public:
+    static constexpr int PRECISION = 15; //same digits as std::setprecision(15)
+
+    void append(const char c) { data.push_back(c); }
+    void append(const char *s) { data.append(s); }
+    void append(const std::string &s) { data.append(s); }
+    void append(const int value) { append_integer(value); }
+    void append(const long value) { append_integer(value); }
+    void append(const long long value) { append_integer(value); }
+    void append(const std::size_t value) { append_integer(value); }
+    void append(const double value) { append_floating(value); }
+    void append(const float value) { append_floating(value); }
+
+    //Append the little-endian bytes of value
+    template <typename T>
+    void append_binary(const T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        if (!host_is_little_endian()) std::reverse(bytes, bytes + sizeof(T));
+        data.append(bytes, sizeof(T));
+    }
+
+    static bool host_is_little_endian() {
+        const std::uint16_t one = 1;
+        return *reinterpret_cast<const unsigned char*>(&one) == 1;
+    }
+
+    const char* c_str() const { return data.data(); }
+    std::size_t size() const { return data.size(); }
+    void clear() { data.clear(); }
+    void reserve(const std::size_t n) { data.reserve(n); }
+
+    void write(std::ostream &out) const { out.write(data.data(), data.size()); }
+};
+
+//Number of items formatted by each thread before writing
+static constexpr long long WRITER_CHUNK_SIZE = 1 << 16;
+
+//Format the items [0, n) with format_item(buffer, i) in parallel and write them to out in order
+template <typename F>
+void write_parallel(std::ostream &out, const long long n, F format_item) {
+    int n_threads = 1;
+#ifdef _OPENMP
+    n_threads = omp_get_max_threads();
+#endif
+    std::vector<TextBuffer> buffers(n_threads);
+    const long long n_chunks = (n + WRITER_CHUNK_SIZE - 1) / WRITER_CHUNK_SIZE;
+
+    //each round formats one chunk per thread, memory is bounded by n_threads chunks
+    for (long long first_chunk = 0; first_chunk < n_chunks; first_chunk += n_threads) {
+        const int round_chunks = static_cast<int>(std::min<long long>(n_threads, n_chunks - first_chunk));
+        #pragma omp parallel for schedule(static, 1)
+        for (int t = 0; t < round_chunks; t++) {
+            TraceScope trace("format_chunk");
+            TextBuffer &buffer = buffers[t];
+            buffer.clear();
+            const long long begin = (first_chunk + t) * WRITER_CHUNK_SIZE;
+            const long long end = std::min(n, begin + WRITER_CHUNK_SIZE);
+            for (long long i = begin; i < end; i++)
+                format_item(buffer, i);
+        }
+        for (int t = 0; t < round_chunks; t++)
+            buffers[t].write(out);
+    }
+}
+
+#endif // BUFFERED_WRITER_HPP
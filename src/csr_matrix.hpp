@@ -0,0 +1,124 @@
+// Sparse matrix in compressed sparse row (CSR) format and a Jacobi
+// preconditioned conjugate gradient solver used by the laplacian-cg smoothing.
+/*
+Basic operations
+    rows(): return the number of rows of the matrix
+    nnz(): return the number of non-zero entries
+    multiply(x, y): y = A*x, rows are processed in parallel when OpenMP is available
+    diagonal(): return the diagonal of the matrix
+    conjugate_gradient(A, b, x, max_iterations, tolerance): solve A*x = b for a symmetric positive definite A
+*/
+
+#ifndef CSR_MATRIX_HPP
+#define CSR_MATRIX_HPP
+
+#include <vector>
+#include <cmath>
+#include <index.hpp>
+
+struct CSRMatrix {
+    std::vector<index_t> row_ptr; //row i is stored in [row_ptr[i], row_ptr[i+1])
+    std::vector<index_t> col_idx; //column of each non-zero entry
+    std::vector<double> values; //value of each non-zero entry
+
+    index_t rows() const {
+        return row_ptr.empty() ? 0 : static_cast<index_t>(row_ptr.size()) - 1;
+    }
+
+    index_t nnz() const {
+        return static_cast<index_t>(values.size());
+    }
+
+    //y = A*x
+    void multiply(const std::vector<double> &x, std::vector<double> &y) const {
+        const index_t n = rows();
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n; i++) {
+            double sum = 0;
+            for (index_t k = row_ptr[i]; k < row_ptr[i+1]; k++)
+                sum += values[k] * x[col_idx[k]];
+            y[i] = sum;
+        }
+    }
+
+    std::vector<double> diagonal() const {
+        const index_t n = rows();
+        std::vector<double> diag(n, 0);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n; i++) {
+            for (index_t k = row_ptr[i]; k < row_ptr[i+1]; k++) {
+                if (col_idx[k] == i) {
+                    diag[i] = values[k];
+                    break;
+                }
+            }
+        }
+        return diag;
+    }
+};
+
+static double csr_dot(const std::vector<double> &a, const std::vector<double> &b) {
+    const index_t n = static_cast<index_t>(a.size());
+    double sum = 0;
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+    for (index_t i = 0; i < n; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+//Solve A*x = b with a Jacobi preconditioned conjugate gradient
+//input: symmetric positive definite matrix A, right hand side b, initial guess x
+//output: x is overwritten with the solution, returns the number of iterations performed
+static int conjugate_gradient(const CSRMatrix &A, const std::vector<double> &b, std::vector<double> &x,
+                              int max_iterations, double tolerance) {
+    const index_t n = A.rows();
+    if (n == 0) return 0;
+
+    std::vector<double> inv_diag = A.diagonal();
+    #pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; i++)
+        inv_diag[i] = (inv_diag[i] != 0) ? 1.0 / inv_diag[i] : 1.0;
+
+    std::vector<double> r(n), z(n), p(n), Ap(n);
+
+    //r = b - A*x, z = M^-1 r, p = z
+    A.multiply(x, Ap);
+    #pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; i++) {
+        r[i] = b[i] - Ap[i];
+        z[i] = inv_diag[i] * r[i];
+        p[i] = z[i];
+    }
+
+    double b_norm = std::sqrt(csr_dot(b, b));
+    if (b_norm == 0) b_norm = 1;
+    double rz = csr_dot(r, z);
+
+    int iteration = 0;
+    while (iteration < max_iterations && std::sqrt(csr_dot(r, r)) / b_norm > tolerance) {
+        A.multiply(p, Ap);
+        double pAp = csr_dot(p, Ap);
+        if (pAp <= 0) break; //matrix is not positive definite in this direction
+        double alpha = rz / pAp;
+
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n; i++) {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+            z[i] = inv_diag[i] * r[i];
+        }
+
+        double rz_new = csr_dot(r, z);
+        double beta = rz_new / rz;
+        rz = rz_new;
+
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n; i++)
+            p[i] = z[i] + beta * p[i];
+
+        iteration++;
+    }
+    return iteration;
+}
+
+#endif // CSR_MATRIX_HPP
@@ -0,0 +1,23 @@
+// Index type of the vertices, half-edges and faces of the meshes
+// The default 32-bit indices address meshes up to 2^31 half-edges (about 700M triangles),
+// the builds with POLYLLA_INDEX64 use 64-bit indices for larger meshes
+/*
+Basic operations
+    index_t: signed index, -1 is used for the missing neighbours and half-edges
+    INDEX_BITS: 32 or 64
+*/
+
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <cstdint>
+
+#ifdef POLYLLA_INDEX64
+typedef std::int64_t index_t;
+#else
+typedef std::int32_t index_t;
+#endif
+
+static constexpr int INDEX_BITS = 8 * sizeof(index_t);
+
+#endif // INDEX_HPP
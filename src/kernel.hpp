@@ -0,0 +1,188 @@
+// Kernel of simple polygons
+// The kernel of a polygon P is the set of points of P that see every point of P,
+// it is the intersection of the inner half-planes of the edges of P and P is star-shaped
+// iff its kernel is not empty.
+/*
+Basic operations
+    polygon_kernel(poly, kernel): compute the kernel of the CCW polygon poly, return its area
+        - convex polygons: the kernel is the polygon, O(n)
+        - few reflex vertices (r <= log2 n): P clipped with the edges incident to reflex vertices, O(n r)
+        - otherwise: half-plane intersection of all the edges, O(n log n)
+    signed_area(poly): signed area of a polygon, positive if it is in CCW order
+*/
+
+#ifndef KERNEL_HPP
+#define KERNEL_HPP
+
+#include <array>
+#include <vector>
+#include <deque>
+#include <cmath>
+#include <algorithm>
+
+typedef std::array<double,2> kernel_point;
+
+class PolygonKernel {
+private:
+    struct half_plane {
+        kernel_point p; //point on the line
+        kernel_point d; //unit direction, the half-plane is on the left
+        double angle;
+    };
+
+    static double cross(const kernel_point &a, const kernel_point &b, const kernel_point &p) {
+        return (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+    }
+
+    //Signed distance of p to the line of h, positive on the inner side
+    static double side(const half_plane &h, const kernel_point &p) {
+        return h.d[0] * (p[1] - h.p[1]) - h.d[1] * (p[0] - h.p[0]);
+    }
+
+    static kernel_point line_intersection(const half_plane &a, const half_plane &b) {
+        double den = a.d[0] * b.d[1] - a.d[1] * b.d[0];
+        double t = ((b.p[0] - a.p[0]) * b.d[1] - (b.p[1] - a.p[1]) * b.d[0]) / den;
+        return {a.p[0] + t * a.d[0], a.p[1] + t * a.d[1]};
+    }
+
+    static half_plane edge_half_plane(const kernel_point &a, const kernel_point &b) {
+        double dx = b[0] - a[0];
+        double dy = b[1] - a[1];
+        double len = std::sqrt(dx*dx + dy*dy);
+        return {a, {dx / len, dy / len}, std::atan2(dy, dx)};
+    }
+
+    //Keep the part of region to the left of the line a->b
+    //region may be non convex, the result can have zero-area bridges on the line but its area is exact
+    static void clip(std::vector<kernel_point> &region, const kernel_point &a, const kernel_point &b, double eps) {
+        std::vector<kernel_point> clipped;
+        clipped.reserve(region.size() + 2);
+        double len = std::hypot(b[0] - a[0], b[1] - a[1]);
+        for (std::size_t i = 0; i < region.size(); i++) {
+            const kernel_point &p = region[i];
+            const kernel_point &q = region[(i + 1) % region.size()];
+            double cp = cross(a, b, p) / len;
+            double cq = cross(a, b, q) / len;
+            if (cp >= -eps) clipped.push_back(p);
+            if ((cp > eps && cq < -eps) || (cp < -eps && cq > eps)) {
+                double t = cp / (cp - cq);
+                clipped.push_back({p[0] + t * (q[0] - p[0]), p[1] + t * (q[1] - p[1])});
+            }
+        }
+        region.swap(clipped);
+    }
+
+    //Half-plane intersection of the edges of poly, O(n log n)
+    static void half_plane_intersection(const std::vector<kernel_point> &poly, std::vector<kernel_point> &kernel, double eps) {
+        const std::size_t n = poly.size();
+        std::vector<half_plane> planes;
+        planes.reserve(n);
+        for (std::size_t i = 0; i < n; i++) {
+            const kernel_point &a = poly[i];
+            const kernel_point &b = poly[(i + 1) % n];
+            if (a[0] == b[0] && a[1] == b[1]) continue;
+            planes.push_back(edge_half_plane(a, b));
+        }
+        //sort by angle, for parallel half-planes with the same direction the most restrictive goes last
+        std::sort(planes.begin(), planes.end(), [](const half_plane &a, const half_plane &b) {
+            if (a.angle != b.angle) return a.angle < b.angle;
+            return side(a, b.p) > 0;
+        });
+
+        std::deque<half_plane> dq;
+        for (std::size_t i = 0; i < planes.size(); i++) {
+            const half_plane &h = planes[i];
+            if (i + 1 < planes.size() && planes[i + 1].angle == h.angle) continue;
+            while (dq.size() >= 2 && side(h, line_intersection(dq[dq.size() - 1], dq[dq.size() - 2])) < -eps)
+                dq.pop_back();
+            while (dq.size() >= 2 && side(h, line_intersection(dq[0], dq[1])) < -eps)
+                dq.pop_front();
+            if (!dq.empty()) {
+                const half_plane &last = dq.back();
+                double den = last.d[0] * h.d[1] - last.d[1] * h.d[0];
+                if (std::abs(den) < 1e-15) {
+                    //parallel with opposite directions and disjoint: empty kernel
+                    if (last.d[0] * h.d[0] + last.d[1] * h.d[1] < 0 && side(h, last.p) < -eps) {
+                        kernel.clear();
+                        return;
+                    }
+                    if (last.d[0] * h.d[0] + last.d[1] * h.d[1] > 0) {
+                        if (side(last, h.p) > 0) dq.back() = h;
+                        continue;
+                    }
+                }
+            }
+            dq.push_back(h);
+        }
+        while (dq.size() >= 3 && side(dq[0], line_intersection(dq[dq.size() - 1], dq[dq.size() - 2])) < -eps)
+            dq.pop_back();
+        while (dq.size() >= 3 && side(dq[dq.size() - 1], line_intersection(dq[0], dq[1])) < -eps)
+            dq.pop_front();
+
+        kernel.clear();
+        if (dq.size() < 3) return;
+        for (std::size_t i = 0; i < dq.size(); i++)
+            kernel.push_back(line_intersection(dq[i], dq[(i + 1) % dq.size()]));
+    }
+
+public:
+    static double signed_area(const std::vector<kernel_point> &poly) {
+        double area = 0;
+        for (std::size_t i = 0; i < poly.size(); i++) {
+            const kernel_point &p0 = poly[i];
+            const kernel_point &p1 = poly[(i + 1) % poly.size()];
+            area += p0[0] * p1[1] - p1[0] * p0[1];
+        }
+        return area / 2;
+    }
+
+    //Compute the kernel of the polygon poly, given in CCW order
+    //input: polygon poly
+    //output: kernel is overwritten with the kernel polygon (empty if poly is not star-shaped), return the area of the kernel
+    static double polygon_kernel(const std::vector<kernel_point> &poly, std::vector<kernel_point> &kernel) {
+        const std::size_t n = poly.size();
+        kernel.clear();
+        if (n < 3) return 0;
+
+        double x_min = poly[0][0], x_max = poly[0][0], y_min = poly[0][1], y_max = poly[0][1];
+        for (auto &p : poly) {
+            x_min = std::min(x_min, p[0]); x_max = std::max(x_max, p[0]);
+            y_min = std::min(y_min, p[1]); y_max = std::max(y_max, p[1]);
+        }
+        const double eps = 1e-12 * std::max(x_max - x_min, y_max - y_min);
+
+        //reflex vertices
+        std::vector<std::size_t> reflex;
+        for (std::size_t i = 0; i < n; i++) {
+            const kernel_point &a = poly[(i + n - 1) % n];
+            const kernel_point &b = poly[(i + 1) % n];
+            double len = std::hypot(b[0] - a[0], b[1] - a[1]);
+            if (len > 0 && cross(a, poly[i], b) / len < -eps)
+                reflex.push_back(i);
+        }
+
+        if (reflex.empty()) {
+            kernel = poly;
+        } else if (reflex.size() <= std::log2(static_cast<double>(n))) {
+            //P is star-shaped iff it intersects the inner half-planes of the edges incident to its reflex vertices
+            kernel = poly;
+            for (std::size_t k = 0; k < reflex.size() && kernel.size() > 2; k++) {
+                std::size_t i = reflex[k];
+                const kernel_point &prev = poly[(i + n - 1) % n];
+                const kernel_point &next = poly[(i + 1) % n];
+                clip(kernel, prev, poly[i], eps);
+                if (kernel.size() > 2) clip(kernel, poly[i], next, eps);
+            }
+        } else {
+            half_plane_intersection(poly, kernel, eps);
+        }
+
+        if (kernel.size() < 3) {
+            kernel.clear();
+            return 0;
+        }
+        return std::abs(signed_area(kernel));
+    }
+};
+
+#endif // KERNEL_HPP
@@ -0,0 +1,79 @@
+#ifndef MEASURE_ANGLE_HPP
+#define MEASURE_ANGLE_HPP
+
+#include <measure.hpp>
+#include <triangulation.hpp>
+#include <cmath>
+
+// Angle in degrees at p2 between p1 and p3, measured as in utils.py::angle_between
+// For polygons in CCW order it is the interior angle of the polygon at p2, for polygons
+// in CW order (OFF inputs with CW triangles) the interior angle is 360 minus this value
+static double angle_between(double x1, double y1, double x2, double y2, double x3, double y3) {
+    const double rad_to_deg = 180.0 / M_PI;
+    double deg1 = std::fmod(360 + std::atan2(x1 - x2, y1 - y2) * rad_to_deg, 360);
+    double deg2 = std::fmod(360 + std::atan2(x3 - x2, y3 - y2) * rad_to_deg, 360);
+    return (deg1 <= deg2) ? deg2 - deg1 : 360 - (deg1 - deg2);
+}
+
+// Interior angle of the polygon at the target of the halfedge e
+static double polygon_angle(Triangulation *mesh, const index_t e, const bool ccw) {
+    index_t v0 = mesh->origin(e);
+    index_t v1 = mesh->origin(mesh->next(e));
+    index_t v2 = mesh->origin(mesh->next(mesh->next(e)));
+    double angle = angle_between(mesh->get_PointX(v0), mesh->get_PointY(v0),
+                                 mesh->get_PointX(v1), mesh->get_PointY(v1),
+                                 mesh->get_PointX(v2), mesh->get_PointY(v2));
+    return ccw ? angle : 360 - angle;
+}
+
+// Smallest interior angle of a polygon
+class MinAngle final : public StaticMeasure<MinAngle> {
+public:
+    using StaticMeasure<MinAngle>::StaticMeasure;
+    double face_value(const index_t face_index) const {
+        double min_angle = 360;
+        bool ccw = polygon_signed_area(face_index) >= 0;
+        index_t e_curr = face_index;
+        do {
+            min_angle = std::min(min_angle, polygon_angle(mesh, e_curr, ccw));
+            e_curr = mesh->next(e_curr);
+        } while (face_index != e_curr);
+        return min_angle;
+    }
+    bool better(const double val1, const double val2) const {
+        return val1 > val2;
+    }
+    const std::string name() const override {
+        return "min_angle";
+    }
+    const double range_max() const override {
+        return 360;
+    }
+};
+
+// Largest interior angle of a polygon
+class MaxAngle final : public StaticMeasure<MaxAngle> {
+public:
+    using StaticMeasure<MaxAngle>::StaticMeasure;
+    double face_value(const index_t face_index) const {
+        double max_angle = 0;
+        bool ccw = polygon_signed_area(face_index) >= 0;
+        index_t e_curr = face_index;
+        do {
+            max_angle = std::max(max_angle, polygon_angle(mesh, e_curr, ccw));
+            e_curr = mesh->next(e_curr);
+        } while (face_index != e_curr);
+        return max_angle;
+    }
+    bool better(const double val1, const double val2) const {
+        return val1 < val2;
+    }
+    const std::string name() const override {
+        return "max_angle";
+    }
+    const double range_max() const override {
+        return 360;
+    }
+};
+
+#endif // MEASURE_ANGLE_HPP
@@ -0,0 +1,25 @@
+#ifndef MEASURE_APR_HPP
+#define MEASURE_APR_HPP
+
+#include <measure.hpp>
+#include <triangulation.hpp>
+#include <cmath>
+
+// Area perimeter ratio of a polygon, 2*pi*area/perimeter^2 as in analytics.py
+class APR final : public StaticMeasure<APR> {
+public:
+    using StaticMeasure<APR>::StaticMeasure;
+    double face_value(const index_t face_index) const {
+        double perimeter = polygon_perimeter(face_index);
+        if (perimeter == 0) return 0;
+        return 2 * M_PI * std::abs(polygon_signed_area(face_index)) / (perimeter * perimeter);
+    }
+    bool better(const double val1, const double val2) const {
+        return val1 > val2;
+    }
+    const std::string name() const override {
+        return "apr";
+    }
+};
+
+#endif // MEASURE_APR_HPP
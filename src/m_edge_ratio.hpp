@@ -4,12 +4,12 @@
 #include <measure.hpp>
 #include <triangulation.hpp>
 
-class EdgeRatio : public Measure {
+class EdgeRatio final : public StaticMeasure<EdgeRatio> {
 private:
 public:
-    using Measure::Measure;
-    const double eval_face(const int face_index) const {
-        int e_curr = face_index;
+    using StaticMeasure<EdgeRatio>::StaticMeasure;
+    double face_value(const index_t face_index) const {
+        index_t e_curr = face_index;
         double max_edge = -1;
         double min_edge = -1;
         do {
@@ -21,11 +21,41 @@ public:
             e_curr = mesh->next(e_curr);
         } while (face_index != e_curr);
         return min_edge / max_edge;
-    };
-    virtual const bool is_better(const double val1, const double val2) const {
+    }
+    bool better(const double val1, const double val2) const {
         return val1 > val2;
     }
+    const std::string name() const override {
+        return "squared_edge_ratio";
+    }
+
+};
 
+// Ratio between the shortest and the longest edge of a polygon
+// EdgeRatio compares squared lengths, enough to rank the moves of the smoothing,
+// this is the ratio of the lengths reported in the quality stats
+class EdgeLengthRatio final : public StaticMeasure<EdgeLengthRatio> {
+public:
+    using StaticMeasure<EdgeLengthRatio>::StaticMeasure;
+    double face_value(const index_t face_index) const {
+        index_t e_curr = face_index;
+        double max_edge = mesh->distance(e_curr);
+        double min_edge = max_edge;
+        e_curr = mesh->next(e_curr);
+        while (face_index != e_curr) {
+            double e_length = mesh->distance(e_curr);
+            max_edge = std::max(max_edge, e_length);
+            min_edge = std::min(min_edge, e_length);
+            e_curr = mesh->next(e_curr);
+        }
+        return std::sqrt(min_edge / max_edge);
+    }
+    bool better(const double val1, const double val2) const {
+        return val1 > val2;
+    }
+    const std::string name() const override {
+        return "edge_ratio";
+    }
 };
 
 #endif // MEASURE_EDGE_RATIO_HPP
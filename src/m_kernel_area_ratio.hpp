@@ -0,0 +1,45 @@
+#ifndef MEASURE_KERNEL_AREA_RATIO_HPP
+#define MEASURE_KERNEL_AREA_RATIO_HPP
+
+#include <measure.hpp>
+#include <triangulation.hpp>
+#include <kernel.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// Ratio between the area of the kernel of a polygon and the area of the polygon
+// The kernel is computed by PolygonKernel, a polygon is star-shaped iff the ratio is positive
+class KernelAreaRatio final : public StaticMeasure<KernelAreaRatio> {
+public:
+    using StaticMeasure<KernelAreaRatio>::StaticMeasure;
+
+    //Kernel area ratio of the polygon that contains the halfedge e in mesh
+    static double kernel_area_ratio(Triangulation *mesh, const index_t e) {
+        std::vector<kernel_point> poly, kernel;
+        index_t e_curr = e;
+        do {
+            index_t v = mesh->origin(e_curr);
+            poly.push_back({mesh->get_PointX(v), mesh->get_PointY(v)});
+            e_curr = mesh->next(e_curr);
+        } while (e != e_curr);
+
+        double poly_area = PolygonKernel::signed_area(poly);
+        if (poly_area == 0) return 0;
+        if (poly_area < 0) std::reverse(poly.begin(), poly.end()); //CW polygons from OFF inputs
+
+        return PolygonKernel::polygon_kernel(poly, kernel) / std::abs(poly_area);
+    }
+
+    double face_value(const index_t face_index) const {
+        return kernel_area_ratio(mesh, face_index);
+    }
+    bool better(const double val1, const double val2) const {
+        return val1 > val2;
+    }
+    const std::string name() const override {
+        return "kernel_area_ratio";
+    }
+};
+
+#endif // MEASURE_KERNEL_AREA_RATIO_HPP
@@ -3,6 +3,9 @@
 
 #include <triangulation.hpp>
 #include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
 
 class Measure {
 private:
@@ -10,35 +13,115 @@ private:
     double sum = 0;
     double max = -1;
     double min = -1;
+    std::vector<long long> histogram; //number of faces in each of the HISTOGRAM_BINS bins of [range_min, range_max]
 protected:
     Triangulation *mesh;
-    std::vector<int> seeds;
+    std::vector<index_t> seeds;
+
+    //Signed area of the polygon that contains the halfedge e, positive if the polygon is in CCW order
+    double polygon_signed_area(const index_t e) const {
+        double area = 0;
+        index_t e_curr = e;
+        do {
+            index_t v0 = mesh->origin(e_curr);
+            index_t v1 = mesh->origin(mesh->next(e_curr));
+            area += mesh->get_PointX(v0) * mesh->get_PointY(v1) - mesh->get_PointX(v1) * mesh->get_PointY(v0);
+            e_curr = mesh->next(e_curr);
+        } while (e_curr != e);
+        return area / 2;
+    }
+
+    //Perimeter of the polygon that contains the halfedge e
+    double polygon_perimeter(const index_t e) const {
+        double perimeter = 0;
+        index_t e_curr = e;
+        do {
+            perimeter += std::sqrt(mesh->distance(e_curr));
+            e_curr = mesh->next(e_curr);
+        } while (e_curr != e);
+        return perimeter;
+    }
+
 public:
+    static constexpr int HISTOGRAM_BINS = 10;
+
     Measure() {}
-    explicit Measure(Triangulation *mesh, std::vector<int>& seeds) {
-        this->seeds = seeds;
+    template <typename Seeds>
+    explicit Measure(Triangulation *mesh, const Seeds& seeds) {
+        this->seeds.assign(seeds.begin(), seeds.end());
         this->mesh = mesh;
     }
-    virtual const double eval_face(const int face_index) const {
+    virtual ~Measure() {}
+    virtual const double eval_face(const index_t face_index) const {
         return 0;
     };
     virtual const bool is_better(const double val1, const double val2) const {
         return false;
     }
+    //Name used in the stats file
+    virtual const std::string name() const {
+        return "measure";
+    }
+    //Range of the values of the measure, used for the histogram
+    virtual const double range_min() const {
+        return 0;
+    }
+    virtual const double range_max() const {
+        return 1;
+    }
+    //Evaluate all the faces, faces are evaluated in parallel when OpenMP is available
     void eval_mesh() {
-        for(auto &e_init : seeds){
-            double face_res = eval_face(e_init);
-            this->sum += face_res;
-            if (this->max == -1) this->max = face_res;
-            if (this->min == -1) this->min = face_res;
-            this->max = std::max(this->max, face_res);
-            this->min = std::min(this->min, face_res);
+        const index_t n = seeds.size();
+        histogram.assign(HISTOGRAM_BINS, 0);
+        if (n == 0) return;
+        const double lo = range_min();
+        const double width = (range_max() - range_min()) / HISTOGRAM_BINS;
+        double total = 0;
+        double max_value = eval_face(seeds[0]);
+        double min_value = max_value;
+        long long *bins = histogram.data();
+        #pragma omp parallel for schedule(dynamic, 1024) reduction(+:total) reduction(max:max_value) reduction(min:min_value) reduction(+:bins[:HISTOGRAM_BINS])
+        for (index_t i = 0; i < n; i++) {
+            double face_res = eval_face(seeds[i]);
+            total += face_res;
+            max_value = std::max(max_value, face_res);
+            min_value = std::min(min_value, face_res);
+            int bin = static_cast<int>((face_res - lo) / width);
+            bins[std::min(std::max(bin, 0), HISTOGRAM_BINS - 1)]++;
         }
+        this->sum = total;
+        this->max = max_value;
+        this->min = min_value;
         this->average = this->sum / this->seeds.size();
     }
     const double getAverage() const {
         return average;
     }
+    const double getMin() const {
+        return min;
+    }
+    const double getMax() const {
+        return max;
+    }
+    const std::vector<long long>& getHistogram() const {
+        return histogram;
+    }
+};
+
+// Base for measures with static dispatch (CRTP)
+// Derived classes implement face_value and better as non-virtual inline members,
+// code templated on the measure type calls them directly while the virtual
+// interface of Measure keeps working through eval_face and is_better
+template <typename Derived>
+class StaticMeasure : public Measure {
+public:
+    using Measure::Measure;
+    const double eval_face(const index_t face_index) const override {
+        return static_cast<const Derived*>(this)->face_value(face_index);
+    }
+    const bool is_better(const double val1, const double val2) const override {
+        return static_cast<const Derived*>(this)->better(val1, val2);
+    }
 };
 
 #endif // MEASURE_HPP
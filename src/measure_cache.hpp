@@ -0,0 +1,42 @@
+#ifndef MEASURE_CACHE_HPP
+#define MEASURE_CACHE_HPP
+
+#include <triangulation.hpp>
+#include <vector>
+
+// Per-face cache of a measure over the triangles of a mesh
+// Values are computed the first time a face is requested and kept until a
+// vertex of the face moves, then only the faces incident to that vertex are refreshed
+// M is a StaticMeasure so the calls to face_value are resolved at compile time.
+template <typename M>
+class MeasureCache {
+private:
+    const M &measure;
+    Triangulation *mesh;
+    std::vector<double> values; //value of each face
+    std::vector<char> valid; //true if values[f] is up to date
+
+public:
+    MeasureCache(const M &measure, Triangulation *mesh)
+        : measure(measure), mesh(mesh), values(mesh->faces(), 0), valid(mesh->faces(), false) {}
+
+    //Return the value of the face incident to the interior halfedge e
+    double eval_face(const index_t e) {
+        index_t f = mesh->index_face(e);
+        if (!valid[f]) {
+            values[f] = measure.face_value(e);
+            valid[f] = true;
+        }
+        return values[f];
+    }
+
+    //Store an already computed value of the face incident to e,
+    //used to refresh the faces incident to a vertex after it moves
+    void store(const index_t e, const double value) {
+        index_t f = mesh->index_face(e);
+        values[f] = value;
+        valid[f] = true;
+    }
+};
+
+#endif // MEASURE_CACHE_HPP
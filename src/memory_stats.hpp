@@ -0,0 +1,201 @@
+// Memory accounting of the phases: peak heap, number of allocations and resident set size.
+// The heap counters come from malloc_count, which replaces malloc/free in the programs built
+// with POLYLLA_MALLOC_COUNT, the resident set size is read from /proc/self/status.
+/*
+Basic operations
+    MemoryStats::instance(): global statistics
+    heap_available(): true if the heap counters are available (malloc_count is linked)
+    peak_heap(): maximum heap allocated since the start of the program, -1 if unavailable
+    current_rss(), peak_rss(): VmRSS and VmHWM of the process in bytes, -1 if unavailable
+    phases(): memory of each phase, in the order of their first run
+    begin_run(): drop the phases of the previous meshes, the phases of the next mesh are its own
+    set_concurrent(on), concurrent(): meshes processed by several threads at once share the heap counters,
+        the peak heap and allocations of the phases are then not per phase
+    MemoryScope scope("name"): account the memory of a phase from the construction of scope to its destruction
+*/
+
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef POLYLLA_MALLOC_COUNT
+#include <malloc_count-0.7.1/malloc_count.h>
+#endif
+
+struct phase_memory {
+    const char *name;
+    long long peak_heap;   //bytes, maximum heap allocated during the phase, -1 if unavailable
+    long long allocations; //number of allocations during the phase, -1 if unavailable
+    long long rss;         //bytes, resident set size at the end of the phase, -1 if unavailable
+};
+
+class MemoryStats {
+private:
+    //phase being accounted, phases can be nested
+    struct open_phase {
+        long long allocations_start;
+        long long peak_children; //peak heap of the nested phases
+    };
+
+    std::mutex phases_mutex;
+    std::vector<phase_memory> phase_list;
+    long long peak_before_reset = -1; //peak heap lost by the resets of the peak at the start of the phases
+    std::atomic<bool> concurrent_meshes{false};
+
+    //each thread opens and closes its phases in LIFO order
+    static std::vector<open_phase>& open_phases() {
+        thread_local std::vector<open_phase> stack;
+        return stack;
+    }
+
+    //Value of key in /proc/self/status in bytes, -1 if not found
+    //The file is read into a fixed buffer, the phases of a loop over many meshes do not allocate
+    static long long read_status(const char *key) {
+#ifdef __linux__
+        char buffer[4096];
+        int fd = open("/proc/self/status", O_RDONLY);
+        if (fd < 0) return -1;
+        ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (length <= 0) return -1;
+        buffer[length] = '\0';
+        const std::size_t key_length = std::strlen(key);
+        for (const char *line = buffer; *line != '\0'; ) {
+            if (std::strncmp(line, key, key_length) == 0 && line[key_length] == ':') {
+                long long kb = std::strtoll(line + key_length + 1, nullptr, 10);
+                return kb < 0 ? -1 : kb * 1024;
+            }
+            const char *end = std::strchr(line, '\n');
+            if (end == nullptr) break;
+            line = end + 1;
+        }
+#endif
+        return -1;
+    }
+
+public:
+    static MemoryStats& instance() {
+        static MemoryStats stats;
+        return stats;
+    }
+
+    static bool heap_available() {
+#ifdef POLYLLA_MALLOC_COUNT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static long long heap_peak_counter() {
+#ifdef POLYLLA_MALLOC_COUNT
+        return static_cast<long long>(malloc_count_peak());
+#else
+        return -1;
+#endif
+    }
+
+    static long long heap_allocations() {
+#ifdef POLYLLA_MALLOC_COUNT
+        return static_cast<long long>(malloc_count_num_allocs());
+#else
+        return -1;
+#endif
+    }
+
+    static long long current_rss() { return read_status("VmRSS"); }
+    static long long peak_rss() { return read_status("VmHWM"); }
+
+    //The peak is not reset at the start of the phases while it is on, the phases of one mesh would
+    //reset the peak of the phases of the others
+    void set_concurrent(const bool on) { concurrent_meshes = on; }
+    bool concurrent() const { return concurrent_meshes; }
+
+    //The phases are kept while other meshes are processed at the same time, they are still running theirs
+    void begin_run() {
+        if (concurrent_meshes) return;
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        phase_list.clear();
+    }
+
+    long long peak_heap() {
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        return std::max(peak_before_reset, heap_peak_counter());
+    }
+
+    void begin_phase() {
+        long long peak = heap_peak_counter();
+        std::vector<open_phase> &stack = open_phases();
+        if (!stack.empty()) stack.back().peak_children = std::max(stack.back().peak_children, peak);
+        {
+            std::lock_guard<std::mutex> lock(phases_mutex);
+            peak_before_reset = std::max(peak_before_reset, peak);
+        }
+#ifdef POLYLLA_MALLOC_COUNT
+        if (!concurrent_meshes) malloc_count_reset_peak();
+#endif
+        stack.push_back({heap_allocations(), -1});
+    }
+
+    //name must be a string literal, it is stored without copying
+    void end_phase(const char *name) {
+        std::vector<open_phase> &stack = open_phases();
+        open_phase phase = stack.back();
+        stack.pop_back();
+        long long allocations = heap_available() ? heap_allocations() - phase.allocations_start : -1;
+        long long peak = std::max(heap_peak_counter(), phase.peak_children);
+        if (!stack.empty()) stack.back().peak_children = std::max(stack.back().peak_children, peak);
+        long long rss = current_rss();
+
+        //phases that run more than once keep the maximum peak, the total allocations and the last rss
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        for (phase_memory &p : phase_list) {
+            if (std::strcmp(p.name, name) != 0) continue;
+            p.peak_heap = std::max(p.peak_heap, peak);
+            if (allocations >= 0) p.allocations += allocations;
+            p.rss = rss;
+            return;
+        }
+        phase_list.push_back({name, peak, allocations, rss});
+    }
+
+    std::vector<phase_memory> phases() {
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        return phase_list;
+    }
+};
+
+//Memory of a phase, from the construction to the destruction of the scope
+//name must be a string literal, it is stored without copying
+class MemoryScope {
+private:
+    const char *name;
+
+public:
+    explicit MemoryScope(const char *name) : name(name) {
+        MemoryStats::instance().begin_phase();
+    }
+
+    ~MemoryScope() {
+        MemoryStats::instance().end_phase(name);
+    }
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+};
+
+#endif // MEMORY_STATS_HPP
@@ -0,0 +1,192 @@
+// NUMA placement of the threads and of the memory (Linux).
+// The OpenMP threads can be pinned to a core each or to the cpus of a NUMA node, consecutive threads
+// share a node, so the consecutive chunks of schedule(static) loops run on the same node. The arrays
+// of storage.hpp are first touched with the same static partition, see ArrayStorage::allocate.
+// The nodes are read from /sys/devices/system/node and the placement of the memory from
+// /proc/self/numa_maps, on other systems there is a single node and pinning is unavailable.
+/*
+Basic operations
+    NumaPlacement::instance(): global placement
+    parse_pin(name): pin_mode by name (none, cores, nodes), throws std::invalid_argument otherwise
+    pin_threads(mode): pin the OpenMP threads, return false if the affinity can not be set
+    pin(), pin_name(mode), error(): requested pinning and the reason of a failure
+    node_cpus(): cpus of each node allowed to the process
+    thread_nodes(): node of each pinned thread
+    node_bytes(): bytes of the process placed on each node, empty if unavailable
+*/
+
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum pin_mode { PIN_NONE, PIN_CORES, PIN_NODES };
+
+inline pin_mode parse_pin(const std::string &name) {
+    if (name == "none") return PIN_NONE;
+    if (name == "cores") return PIN_CORES;
+    if (name == "nodes") return PIN_NODES;
+    throw std::invalid_argument("unknown pinning '" + name + "', use none, cores or nodes");
+}
+
+class NumaPlacement {
+private:
+    pin_mode requested = PIN_NONE;
+    std::string pin_error;
+    std::vector<int> threads_node; //node of each thread after pin_threads
+
+    //Cpus of a list like "0-3,8,10-11"
+    static std::vector<int> parse_cpulist(const std::string &list) {
+        std::vector<int> cpus;
+        std::stringstream ranges(list);
+        std::string range;
+        while (std::getline(ranges, range, ',')) {
+            if (range.empty() || range == "\n") continue;
+            int first = -1, last = -1;
+            char dash;
+            std::istringstream bounds(range);
+            bounds>>first;
+            if (!(bounds>>dash>>last)) last = first;
+            for (int c = first; c >= 0 && c <= last; c++) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+#ifdef __linux__
+    static bool cpu_allowed(const cpu_set_t &allowed, const int cpu) {
+        return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+    }
+#endif
+
+public:
+    static NumaPlacement& instance() {
+        static NumaPlacement placement;
+        return placement;
+    }
+
+    //Allowed cpus of each node, a single node with the allowed cpus when the nodes are unknown
+    static std::vector<std::vector<int>> node_cpus() {
+        std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return nodes;
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string online_list;
+        std::getline(online, online_list);
+        for (int node : parse_cpulist(online_list)) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string list;
+            std::getline(cpulist, list);
+            std::vector<int> cpus;
+            for (int cpu : parse_cpulist(list))
+                if (cpu_allowed(allowed, cpu)) cpus.push_back(cpu);
+            if (!cpus.empty()) nodes.push_back(cpus);
+        }
+        if (nodes.empty()) {
+            nodes.emplace_back();
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                if (cpu_allowed(allowed, cpu)) nodes.back().push_back(cpu);
+        }
+#endif
+        return nodes;
+    }
+
+    //Thread t of n is bound to the node t*nodes/n, with PIN_CORES to a single cpu of that node
+    bool pin_threads(const pin_mode mode) {
+        requested = mode;
+        threads_node.clear();
+        if (mode == PIN_NONE) return true;
+#ifdef __linux__
+        const std::vector<std::vector<int>> nodes = node_cpus();
+        if (nodes.empty()) {
+            pin_error = "the allowed cpus of the process are unknown";
+            return false;
+        }
+        int n_threads = 1;
+#ifdef _OPENMP
+        n_threads = omp_get_max_threads();
+#endif
+        threads_node.assign(n_threads, 0);
+        std::vector<int> errors(n_threads, 0);
+        //each thread of the OpenMP pool pins itself, the pool is reused by the later parallel regions
+        #pragma omp parallel for schedule(static, 1)
+        for (int t = 0; t < n_threads; t++) {
+            const int node = static_cast<int>(static_cast<long long>(t) * nodes.size() / n_threads);
+            const std::vector<int> &cpus = nodes[node];
+            //threads of the node are numbered from its first thread
+            const int first = static_cast<int>((static_cast<long long>(node) * n_threads + nodes.size() - 1) / nodes.size());
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (mode == PIN_CORES)
+                CPU_SET(cpus[(t - first) % cpus.size()], &set);
+            else
+                for (int cpu : cpus) CPU_SET(cpu, &set);
+            if (sched_setaffinity(0, sizeof(set), &set) != 0) errors[t] = errno;
+            threads_node[t] = node;
+        }
+        for (int error : errors) {
+            if (error == 0) continue;
+            pin_error = std::strerror(error);
+            return false;
+        }
+        return true;
+#else
+        pin_error = "thread pinning is only available on Linux";
+        return false;
+#endif
+    }
+
+    pin_mode pin() const { return requested; }
+    const std::string& error() const { return pin_error; }
+    const std::vector<int>& thread_nodes() const { return threads_node; }
+
+    static const char* pin_name(const pin_mode mode) {
+        static const char *names[] = {"none", "cores", "nodes"};
+        return names[mode];
+    }
+
+    //Sum of the pages of every mapping of the process on each node, N<node>=<pages> in /proc/self/numa_maps
+    static std::vector<long long> node_bytes() {
+        std::vector<long long> bytes;
+        std::ifstream maps("/proc/self/numa_maps");
+        std::string line;
+        while (std::getline(maps, line)) {
+            std::istringstream fields(line);
+            std::string field;
+            std::vector<std::pair<int, long long>> pages;
+            long long page_kb = 4;
+            while (fields>>field) {
+                if (field.compare(0, 17, "kernelpagesize_kB") == 0) {
+                    page_kb = std::stoll(field.substr(18));
+                } else if (field.size() > 2 && field[0] == 'N' && std::isdigit(static_cast<unsigned char>(field[1]))) {
+                    std::size_t eq = field.find('=');
+                    if (eq == std::string::npos) continue;
+                    pages.emplace_back(std::stoi(field.substr(1, eq - 1)), std::stoll(field.substr(eq + 1)));
+                }
+            }
+            for (auto &p : pages) {
+                if (p.first >= static_cast<int>(bytes.size())) bytes.resize(p.first + 1, 0);
+                bytes[p.first] += p.second * page_kb * 1024;
+            }
+        }
+        return bytes;
+    }
+};
+
+#endif // NUMA_HPP
@@ -0,0 +1,218 @@
+// Hardware performance counters of the phases, read with perf_event_open (Linux).
+// The counters are opened on the calling thread and on each OpenMP thread and their sum
+// is recorded per phase. Events that can not be opened (no PMU, perf_event_paranoid,
+// containers, other systems) are reported as unavailable and the program runs normally.
+/*
+Basic operations
+    PerfCounters::instance(): global counters
+    enable(): open the counters, return false if none of the events is available
+    is_enabled(): true if the counters are open
+    is_requested(): true if enable() was called, even if the counters are unavailable
+    event_available(event), event_name(event): events of perf_event_kind
+    phases(): counter deltas of each phase, in the order of their first run
+    begin_run(): drop the phases of the previous meshes, the phases of the next mesh are its own
+    PerfScope scope("name"): count the events of a phase from the construction of scope to its destruction
+*/
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum perf_event_kind {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_DTLB_MISSES,
+    N_PERF_EVENTS
+};
+
+typedef std::array<long long, N_PERF_EVENTS> perf_values;
+
+struct phase_counters {
+    const char *name;
+    perf_values values; //events of the phase, summed over the threads and the runs of the phase
+};
+
+class PerfCounters {
+private:
+    bool requested = false; //enable() was called
+    bool enabled = false;
+    std::array<bool, N_PERF_EVENTS> available{};
+    std::vector<std::array<int, N_PERF_EVENTS>> fds; //file descriptors of each thread, -1 if unavailable
+    std::string error;
+    std::mutex phases_mutex;
+    std::vector<phase_counters> phase_list;
+
+#ifdef __linux__
+    static void event_attr(const perf_event_kind event, perf_event_attr &attr) {
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.exclude_kernel = 1; //allowed with perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (event) {
+            case PERF_CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case PERF_INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case PERF_LLC_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case PERF_BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            default:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+        }
+    }
+
+    //Open the events on the calling thread
+    std::array<int, N_PERF_EVENTS> open_thread(std::string &open_error) {
+        std::array<int, N_PERF_EVENTS> thread_fds;
+        for (int e = 0; e < N_PERF_EVENTS; e++) {
+            perf_event_attr attr;
+            event_attr(static_cast<perf_event_kind>(e), attr);
+            thread_fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (thread_fds[e] < 0 && open_error.empty()) open_error = std::strerror(errno);
+        }
+        return thread_fds;
+    }
+
+    //Value of the counter, scaled when the kernel multiplexed it with other events
+    static long long read_counter(const int fd) {
+        std::uint64_t data[3]; //value, time enabled, time running
+        if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return 0;
+        if (data[2] == 0) return 0;
+        if (data[2] == data[1]) return static_cast<long long>(data[0]);
+        return static_cast<long long>(static_cast<double>(data[0]) * data[1] / data[2]);
+    }
+#endif
+
+public:
+    static PerfCounters& instance() {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    bool enable() {
+        requested = true;
+#ifdef __linux__
+        int n_threads = 1;
+#ifdef _OPENMP
+        n_threads = omp_get_max_threads();
+#endif
+        fds.assign(n_threads, {});
+        std::vector<std::string> open_errors(n_threads);
+        //each thread of the OpenMP pool opens its own counters, the pool is reused by the later parallel regions
+        #pragma omp parallel for schedule(static, 1)
+        for (int t = 0; t < n_threads; t++)
+            fds[t] = open_thread(open_errors[t]);
+        //the main thread is the thread 0 of the pool
+        for (int e = 0; e < N_PERF_EVENTS; e++)
+            available[e] = fds[0][e] >= 0;
+        for (auto &thread_fds : fds) {
+            for (int e = 0; e < N_PERF_EVENTS; e++) {
+                if (available[e]) continue;
+                if (thread_fds[e] >= 0) close(thread_fds[e]);
+                thread_fds[e] = -1;
+            }
+        }
+        error = open_errors[0];
+        for (int e = 0; e < N_PERF_EVENTS; e++)
+            enabled = enabled || available[e];
+#else
+        error = "perf_event_open is only available on Linux";
+#endif
+        return enabled;
+    }
+
+    bool is_enabled() const { return enabled; }
+    bool is_requested() const { return requested; }
+    bool event_available(const perf_event_kind event) const { return available[event]; }
+    const std::string& open_error() const { return error; }
+
+    static const char* event_name(const perf_event_kind event) {
+        static const char *names[N_PERF_EVENTS] = {"cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"};
+        return names[event];
+    }
+
+    //Current values of the events, summed over the threads
+    perf_values read_all() const {
+        perf_values values{};
+#ifdef __linux__
+        for (auto &thread_fds : fds)
+            for (int e = 0; e < N_PERF_EVENTS; e++)
+                if (thread_fds[e] >= 0) values[e] += read_counter(thread_fds[e]);
+#endif
+        return values;
+    }
+
+    //name must be a string literal, it is stored without copying
+    void record(const char *name, const perf_values &start, const perf_values &end) {
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        for (phase_counters &p : phase_list) {
+            if (std::strcmp(p.name, name) != 0) continue;
+            for (int e = 0; e < N_PERF_EVENTS; e++) p.values[e] += end[e] - start[e];
+            return;
+        }
+        phase_counters phase = {name, {}};
+        for (int e = 0; e < N_PERF_EVENTS; e++) phase.values[e] = end[e] - start[e];
+        phase_list.push_back(phase);
+    }
+
+    std::vector<phase_counters> phases() {
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        return phase_list;
+    }
+
+    void begin_run() {
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        phase_list.clear();
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (auto &thread_fds : fds)
+            for (int fd : thread_fds)
+                if (fd >= 0) close(fd);
+#endif
+    }
+};
+
+//Events of a phase, from the construction to the destruction of the scope
+//name must be a string literal, it is stored without copying
+class PerfScope {
+private:
+    const char *name;
+    perf_values start{};
+    bool active;
+
+public:
+    explicit PerfScope(const char *name) : name(name), active(PerfCounters::instance().is_enabled()) {
+        if (active) start = PerfCounters::instance().read_all();
+    }
+
+    ~PerfScope() {
+        if (active) PerfCounters::instance().record(name, start, PerfCounters::instance().read_all());
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+};
+
+#endif // PERF_COUNTERS_HPP
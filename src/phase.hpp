@@ -0,0 +1,31 @@
+// Instrumentation of the main phases of the pipeline
+// A phase is traced (trace.hpp), its memory is accounted (memory_stats.hpp) and its hardware
+// events are counted when the counters are enabled (perf_counters.hpp),
+// smaller spans inside a phase use TraceScope only.
+/*
+Basic operations
+    PhaseScope scope("name"): instrument a phase from the construction of scope to its destruction
+*/
+
+#ifndef PHASE_HPP
+#define PHASE_HPP
+
+#include <trace.hpp>
+#include <memory_stats.hpp>
+#include <perf_counters.hpp>
+
+//name must be a string literal, it is stored without copying
+class PhaseScope {
+private:
+    MemoryScope memory;
+    TraceScope trace;
+    PerfScope perf; //innermost, the counters do not include the accounting of the other scopes
+
+public:
+    explicit PhaseScope(const char *name) : memory(name), trace(name), perf(name) {}
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+};
+
+#endif // PHASE_HPP
@@ -15,9 +15,25 @@
 #include <cmath>
 #include <chrono>
 #include <iomanip>
+#include <memory>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
 
 #include <triangulation.hpp>
 #include <m_edge_ratio.hpp>
+#include <m_angle.hpp>
+#include <m_kernel_area_ratio.hpp>
+#include <m_apr.hpp>
+#include <measure_cache.hpp>
+#include <csr_matrix.hpp>
+#include <buffered_writer.hpp>
+#include <phase.hpp>
+#include <numa.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define print_e(eddddge) eddddge<<" ( "<<mesh_input->origin(eddddge)<<" - "<<mesh_input->target(eddddge)<<") "
 
@@ -25,48 +41,100 @@
 struct PolyllaOptions {
     // Region options
     bool use_regions = false;
+
+    // Input options
+    bool pipelined_read = false;              // node, ele and neigh: read the files while the half-edges are built
     
     // Smoothing options  
-    std::string smooth_method = "";           // "", "laplacian", "laplacian-edge-ratio", "distmesh"
+    std::string smooth_method = "";           // "", "laplacian", "laplacian-edge-ratio", "distmesh", "laplacian-cg"
     int smooth_iterations = 50;               // default 50
     double target_length = -1;                // -1 = auto-calculate
+    bool validate_moves = false;              // laplacian-cg: undo moves rejected by is_valid_move
+
+    // Quality options
+    bool compute_quality = false;             // evaluate the quality measures of the polygons
+    bool compute_kernels = false;             // compute the kernel of each polygon
+
+    // Locality options
+    std::string reorder = "";                 // "", "hilbert", "morton": renumber the input along the curve
+    bool restore_vertex_order = false;        // write the vertices of the outputs in the input order
+    std::string sort_polygons = "";           // "", "hilbert", "morton": output the polygons in the curve order of their centroids
+
+    // Output options
+    std::ostream *progress = &std::cout;      // stream of the progress messages, nullptr = quiet
+};
+
+// View of the coordinates of the vertices of a mesh, without copying them
+// The coordinates of vertex i are at x[i*stride] and y[i*stride]
+struct CoordinatesView {
+    const double *x = nullptr;
+    const double *y = nullptr;
+    std::size_t stride = 0; //distance in doubles between two consecutive vertices
+    index_t n_vertices = 0;
+
+    double X(const index_t i) const { return x[i * stride]; }
+    double Y(const index_t i) const { return y[i * stride]; }
+};
+
+// Polygon mesh as flat compressed sparse row (CSR) arrays
+// The vertices of polygon i are polygon_vertices[polygon_offsets[i]] ... polygon_vertices[polygon_offsets[i+1] - 1]
+struct PolygonMesh {
+    std::vector<long long> polygon_offsets; //n_polygons + 1 offsets
+    std::vector<index_t> polygon_vertices;
+    std::vector<int> polygon_region; //region of each polygon, empty if regions are not used
+    CoordinatesView coordinates; //valid while the Polylla object is alive
+
+    index_t n_polygons() const { return static_cast<index_t>(polygon_offsets.size()) - 1; }
 };
 
 class Polylla
 {
 private:
-    typedef std::vector<int> _polygon; 
-    typedef std::vector<char> bit_vector; 
+    typedef std::vector<index_t> _polygon; 
+    typedef storage_vector<char> bit_vector; //first touched in parallel, see storage.hpp
 
     static constexpr double EPSILON = 1e-6;
+    static constexpr double CG_TOLERANCE = 1e-8; //relative residual to stop the laplacian-cg solver
+    static constexpr int VTK_POLYGON = 7; //VTK cell type of the polygons in print_VTU
 
     Triangulation *mesh_input; // Halfedge triangulation
     Triangulation *mesh_output;
-    std::vector<int> output_seeds; //Seeds of the polygon
+    storage_vector<index_t> output_seeds; //Seeds of the polygon
 
     //std::vector<int> triangles; //True if the edge generated a triangle CHANGE!!!!
 
     bit_vector max_edges; //True if the edge i is a max edge
     bit_vector frontier_edges; //True if the edge i is a frontier edge
-    std::vector<int> seed_edges; //Seed edges that generate polygon simple and non-simple
+    storage_vector<index_t> seed_edges; //Seed edges that generate polygon simple and non-simple
 
     // Auxiliary array used during the barrier-edge elimination
-    std::vector<int> triangle_list;
+    storage_vector<index_t> triangle_list;
     bit_vector seed_bet_mark;
 
     // Configuration options
     PolyllaOptions options;
 
+    // Vertex written at each line of the outputs, empty unless the input order is restored after a reorder
+    std::vector<index_t> vertex_of_line;
+
     // Pre-computed region boundary edges for smoothing optimization
-    std::vector<bool> region_boundary_edges;
+    bit_vector region_boundary_edges;
+
+    // Quality measures evaluated over the output polygons
+    std::vector<std::unique_ptr<Measure>> quality_measures;
+
+    // Kernel of each output polygon, same order as output_seeds
+    std::vector<double> kernel_area_ratio; //Area of the kernel over the area of the polygon
+    bit_vector star_shaped; //True if the polygon has a kernel with positive area
 
     //Statistics
-    int m_polygons = 0; //Number of polygons
-    int n_frontier_edges = 0; //Number of frontier edges
-    int n_barrier_edge_tips = 0; //Number of barrier edge tips
-    int n_polygons_to_repair = 0;
-    int n_polygons_added_after_repair = 0;
+    index_t m_polygons = 0; //Number of polygons
+    index_t n_frontier_edges = 0; //Number of frontier edges
+    index_t n_barrier_edge_tips = 0; //Number of barrier edge tips
+    index_t n_polygons_to_repair = 0;
+    index_t n_polygons_added_after_repair = 0;
     int n_smooth_iterations = 0;
+    index_t n_star_shaped_polygons = 0;
 
     // Times
     double t_label_max_edges = 0;
@@ -76,6 +144,10 @@ private:
     double t_traversal = 0;
     double t_repair = 0;
     double t_smooth = 0;
+    double t_quality = 0;
+    double t_kernel = 0;
+    double t_reorder = 0;
+    double t_sort_polygons = 0;
     
 public:
 
@@ -84,6 +156,7 @@ public:
     //Constructor with triangulation
     Polylla(Triangulation *input_mesh, const PolyllaOptions& options = PolyllaOptions()) 
         : mesh_input(input_mesh), options(options) {
+        reorder_input();
         mesh_output = new Triangulation(*mesh_input);
         construct_Polylla();
     }
@@ -92,6 +165,7 @@ public:
     Polylla(const std::string& off_file, const PolyllaOptions& options = PolyllaOptions()) 
         : options(options) {
         this->mesh_input = new Triangulation(off_file, options.use_regions);
+        reorder_input();
         mesh_output = new Triangulation(*mesh_input);
         construct_Polylla();
     }
@@ -100,7 +174,8 @@ public:
     Polylla(const std::string& node_file, const std::string& ele_file, const std::string& neigh_file, 
             const PolyllaOptions& options = PolyllaOptions()) 
         : options(options) {
-        this->mesh_input = new Triangulation(node_file, ele_file, neigh_file, options.use_regions);
+        this->mesh_input = new Triangulation(node_file, ele_file, neigh_file, options.use_regions, options.pipelined_read);
+        reorder_input();
         mesh_output = new Triangulation(*mesh_input);
         construct_Polylla();
     }
@@ -110,12 +185,13 @@ public:
             const PolyllaOptions& options = PolyllaOptions()) 
         : options(options) {
         this->mesh_input = new Triangulation(node_file, ele_file, options.use_regions);
+        reorder_input();
         mesh_output = new Triangulation(*mesh_input);
         construct_Polylla();
     }
 
     //Constructor random data construictor
-    Polylla(int size){
+    Polylla(index_t size){
         this->mesh_input = new Triangulation(size);
         mesh_output = new Triangulation(*mesh_input);
         construct_Polylla();
@@ -133,6 +209,12 @@ public:
         delete mesh_output;
     }
 
+    //Stream of the progress messages, a stream without buffer discards them when options.progress is nullptr
+    std::ostream& progress() const {
+        thread_local std::ostream quiet(nullptr);
+        return options.progress != nullptr ? *options.progress : quiet;
+    }
+
     // Configuration methods
     void set_use_regions(bool use_regions) {
         this->options.use_regions = use_regions;
@@ -142,6 +224,23 @@ public:
         return options.use_regions;
     }
 
+    //Renumber the input mesh along a space-filling curve so the phases traverse it with better locality,
+    //must run before mesh_output is copied from mesh_input
+    void reorder_input(){
+        if (options.reorder.empty()) return;
+        auto t_start = std::chrono::high_resolution_clock::now();
+        mesh_input->reorder(parse_curve(options.reorder));
+        if (options.restore_vertex_order) {
+            vertex_of_line.resize(mesh_input->vertices());
+            #pragma omp parallel for schedule(static)
+            for (index_t v = 0; v < mesh_input->vertices(); v++)
+                vertex_of_line[mesh_input->original_vertex(v)] = v;
+        }
+        auto t_end = std::chrono::high_resolution_clock::now();
+        t_reorder = std::chrono::duration<double, std::milli>(t_end-t_start).count();
+        progress()<<"Reordered the input along the "<<options.reorder<<" curve in "<<t_reorder<<" ms"<<std::endl;
+    }
+
     void construct_Polylla(){
 
         max_edges = bit_vector(mesh_input->halfEdges(), false);
@@ -157,14 +256,15 @@ public:
         //terminal_edges = bit_vector(mesh_input->halfEdges(), false);
         //seed_edges = bit_vector(mesh_input->halfEdges(), false);
         
-        std::cout<<"Creating Polylla..."<<std::endl;
+        progress()<<"Creating Polylla..."<<std::endl;
         
         // Apply smoothing FIRST, before any polygon generation
         if (!options.smooth_method.empty()) {
+            PhaseScope phase("smoothing");
             auto t_start = std::chrono::high_resolution_clock::now();
 
             if (options.use_regions) {
-                std::cout << "Smoothing with region boundary preservation enabled" << std::endl;        
+                progress() << "Smoothing with region boundary preservation enabled" << std::endl;        
             }
 
             if (options.smooth_method == "laplacian") {
@@ -176,11 +276,14 @@ public:
             else if (options.smooth_method == "distmesh") {
                 optimize_mesh_distmesh(options.smooth_iterations, options.target_length);
             }
+            else if (options.smooth_method == "laplacian-cg") {
+                optimize_mesh_laplacian_cg(options.smooth_iterations);
+            }
 
             auto t_end = std::chrono::high_resolution_clock::now();
             t_smooth = std::chrono::duration<double, std::milli>(t_end-t_start).count();
             std::string region_info = options.use_regions ? " (preserving region boundaries)" : "";     
-            std::cout<<"Optimized mesh in "<<t_smooth<<" ms using "<<options.smooth_method<<" method"<<region_info<<std::endl;
+            progress()<<"Optimized mesh in "<<t_smooth<<" ms using "<<options.smooth_method<<" method"<<region_info<<std::endl;
             
             // After smoothing, copy smoothed coordinates to mesh_input
             for (std::size_t v = 0; v < mesh_output->vertices(); v++) {
@@ -190,59 +293,86 @@ public:
         }
         //Label max edges of each triangle
         auto t_start = std::chrono::high_resolution_clock::now();
-        for(int i = 0; i < mesh_input->faces(); i++)
-            max_edges[label_max_edge(mesh_input->incident_halfedge(i))] = true;
+        {
+            PhaseScope phase("label_max_edges");
+            //each triangle labels one of its own half-edges
+            #pragma omp parallel for schedule(static)
+            for(index_t i = 0; i < mesh_input->faces(); i++)
+                max_edges[label_max_edge(mesh_input->incident_halfedge(i))] = true;
+        }
          
         auto t_end = std::chrono::high_resolution_clock::now();
         t_label_max_edges = std::chrono::duration<double, std::milli>(t_end-t_start).count();
-        std::cout<<"Labeled max edges in "<<t_label_max_edges<<" ms"<<std::endl;
+        progress()<<"Labeled max edges in "<<t_label_max_edges<<" ms"<<std::endl;
 
         t_start = std::chrono::high_resolution_clock::now();
         //Label frontier edges
-        for (std::size_t e = 0; e < mesh_input->halfEdges(); e++){
-            if(is_frontier_edge(e)){
-                frontier_edges[e] = true;
-                n_frontier_edges++;
+        {
+            PhaseScope phase("label_frontier_edges");
+            index_t n_frontier = 0;
+            #pragma omp parallel for schedule(static) reduction(+:n_frontier)
+            for (index_t e = 0; e < mesh_input->halfEdges(); e++){
+                if(is_frontier_edge(e)){
+                    frontier_edges[e] = true;
+                    n_frontier++;
+                }
             }
+            n_frontier_edges += n_frontier;
         }
 
         t_end = std::chrono::high_resolution_clock::now();
         t_label_frontier_edges = std::chrono::duration<double, std::milli>(t_end-t_start).count();
-        std::cout<<"Labeled frontier edges in "<<t_label_frontier_edges<<" ms"<<std::endl;
+        progress()<<"Labeled frontier edges in "<<t_label_frontier_edges<<" ms"<<std::endl;
         
         t_start = std::chrono::high_resolution_clock::now();
         //label seeds edges,
-        for (std::size_t e = 0; e < mesh_input->halfEdges(); e++)
-            if(mesh_input->is_interior_face(e) && is_seed_edge(e))
-                seed_edges.push_back(e);
+        {
+            PhaseScope phase("label_seed_edges");
+            for (std::size_t e = 0; e < mesh_input->halfEdges(); e++)
+                if(mesh_input->is_interior_face(e) && is_seed_edge(e))
+                    seed_edges.push_back(e);
+        }
 
             
         t_end = std::chrono::high_resolution_clock::now();
         t_label_seed_edges = std::chrono::duration<double, std::milli>(t_end-t_start).count();
-        std::cout<<"Labeled seed edges in "<<t_label_seed_edges<<" ms"<<std::endl;
+        progress()<<"Labeled seed edges in "<<t_label_seed_edges<<" ms"<<std::endl;
 
         //Travel phase: Generate polygon mesh
-        int polygon_seed;
+        index_t polygon_seed;
         //Foreach seed edge generate polygon
         t_start = std::chrono::high_resolution_clock::now();
-        for(auto &e : seed_edges){
-            polygon_seed = travel_triangles(e);
-            //output_seeds.push_back(polygon_seed);
-            if(!has_BarrierEdgeTip(polygon_seed)){ //If the polygon is a simple polygon then is part of the mesh
-                output_seeds.push_back(polygon_seed);
-            }else{ //Else, the polygon is send to reparation phase
-                auto t_start_repair = std::chrono::high_resolution_clock::now();
-                barrieredge_tip_reparation(polygon_seed);
-                auto t_end_repair = std::chrono::high_resolution_clock::now();
-                t_repair += std::chrono::duration<double, std::milli>(t_end_repair-t_start_repair).count();
-            }         
-        }    
+        {
+            PhaseScope phase("traversal_and_repair");
+            for(auto &e : seed_edges){
+                polygon_seed = travel_triangles(e);
+                //output_seeds.push_back(polygon_seed);
+                if(!has_BarrierEdgeTip(polygon_seed)){ //If the polygon is a simple polygon then is part of the mesh
+                    output_seeds.push_back(polygon_seed);
+                }else{ //Else, the polygon is send to reparation phase
+                    TraceScope trace_repair("repair");
+                    auto t_start_repair = std::chrono::high_resolution_clock::now();
+                    barrieredge_tip_reparation(polygon_seed);
+                    auto t_end_repair = std::chrono::high_resolution_clock::now();
+                    t_repair += std::chrono::duration<double, std::milli>(t_end_repair-t_start_repair).count();
+                }         
+            }    
+        }
         t_end = std::chrono::high_resolution_clock::now();
         t_traversal_and_repair = std::chrono::duration<double, std::milli>(t_end-t_start).count();
         t_traversal = t_traversal_and_repair - t_repair;
         
         this->m_polygons = output_seeds.size();
 
+        //the measures, kernels, outputs and triangle map follow output_seeds, so they all see the sorted order
+        if (!options.sort_polygons.empty()) {
+            t_start = std::chrono::high_resolution_clock::now();
+            sort_polygons(parse_curve(options.sort_polygons));
+            t_end = std::chrono::high_resolution_clock::now();
+            t_sort_polygons = std::chrono::duration<double, std::milli>(t_end-t_start).count();
+            progress()<<"Sorted polygons along the "<<options.sort_polygons<<" curve in "<<t_sort_polygons<<" ms"<<std::endl;
+        }
+
         // std::cout << mesh_output->get_PointX(508) << ", " << mesh_output->get_PointY(508) << std::endl;
 
         // for(std::size_t v = 0; v < mesh_input->vertices(); v++) {
@@ -291,23 +421,135 @@ public:
             // std::cout << mesh_input->origin(e_curr) << std::endl;
         // }
         
-        std::cout<<"Mesh with "<<m_polygons<<" polygons "<<n_frontier_edges/2<<" edges and "<<n_barrier_edge_tips<<" barrier-edge tips."<<std::endl;
+        progress()<<"Mesh with "<<m_polygons<<" polygons "<<n_frontier_edges/2<<" edges and "<<n_barrier_edge_tips<<" barrier-edge tips."<<std::endl;
         //mesh_input->print_pg(std::to_string(mesh_input->vertices()) + ".pg");             
+
+        if (options.compute_quality) {
+            t_start = std::chrono::high_resolution_clock::now();
+            compute_quality_measures();
+            t_end = std::chrono::high_resolution_clock::now();
+            t_quality = std::chrono::duration<double, std::milli>(t_end-t_start).count();
+            progress()<<"Evaluated quality measures in "<<t_quality<<" ms"<<std::endl;
+        }
+
+        if (options.compute_kernels) {
+            t_start = std::chrono::high_resolution_clock::now();
+            compute_kernels();
+            t_end = std::chrono::high_resolution_clock::now();
+            t_kernel = std::chrono::duration<double, std::milli>(t_end-t_start).count();
+            progress()<<"Computed kernels in "<<t_kernel<<" ms, "<<n_star_shaped_polygons<<" of "<<m_polygons<<" polygons are star-shaped"<<std::endl;
+        }
+    }
+
+    //Sort output_seeds by the curve key of the centroid of the vertices of each polygon,
+    //polygons with the same key keep their discovery order
+    void sort_polygons(const space_filling_curve curve){
+        PhaseScope phase("sort_polygons");
+        if (m_polygons == 0) return;
+        Triangulation* coord_mesh = (!options.smooth_method.empty()) ? mesh_output : mesh_input;
+        double min_x = coord_mesh->get_PointX(0), max_x = min_x, min_y = coord_mesh->get_PointY(0), max_y = min_y;
+        for (index_t v = 0; v < coord_mesh->vertices(); v++) {
+            min_x = std::min(min_x, coord_mesh->get_PointX(v));
+            max_x = std::max(max_x, coord_mesh->get_PointX(v));
+            min_y = std::min(min_y, coord_mesh->get_PointY(v));
+            max_y = std::max(max_y, coord_mesh->get_PointY(v));
+        }
+        const CurveGrid grid(min_x, min_y, max_x, max_y, curve);
+
+        std::vector<std::uint32_t> keys(m_polygons);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < m_polygons; i++) {
+            index_t e_init = output_seeds[i];
+            index_t e_curr = e_init;
+            double x = 0, y = 0;
+            long long size_poly = 0;
+            do {
+                x += coord_mesh->get_PointX(mesh_output->origin(e_curr));
+                y += coord_mesh->get_PointY(mesh_output->origin(e_curr));
+                size_poly++;
+                e_curr = mesh_output->next(e_curr);
+            } while (e_curr != e_init);
+            keys[i] = grid.key(x / size_poly, y / size_poly);
+        }
+        const std::vector<index_t> order = sort_by_key(keys);
+        storage_vector<index_t> sorted_seeds(m_polygons);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < m_polygons; i++)
+            sorted_seeds[i] = output_seeds[order[i]];
+        output_seeds.swap(sorted_seeds);
+    }
+
+    //Compute the kernel of each polygon of the mesh in parallel
+    void compute_kernels(){
+        PhaseScope phase("kernels");
+        kernel_area_ratio.assign(m_polygons, 0);
+        star_shaped.assign(m_polygons, false);
+        index_t n_star_shaped = 0;
+        #pragma omp parallel for schedule(dynamic, 256) reduction(+:n_star_shaped)
+        for (index_t i = 0; i < m_polygons; i++) {
+            kernel_area_ratio[i] = KernelAreaRatio::kernel_area_ratio(mesh_output, output_seeds[i]);
+            star_shaped[i] = kernel_area_ratio[i] > 0;
+            n_star_shaped += star_shaped[i];
+        }
+        n_star_shaped_polygons = n_star_shaped;
+    }
+
+    const std::vector<double>& get_kernel_area_ratio() const {
+        return kernel_area_ratio;
+    }
+
+    const bit_vector& get_star_shaped() const {
+        return star_shaped;
+    }
+
+    //Times of the phases of construct_Polylla in ms
+    double get_label_max_edges_time() const { return t_label_max_edges; }
+    double get_label_frontier_edges_time() const { return t_label_frontier_edges; }
+    double get_label_seed_edges_time() const { return t_label_seed_edges; }
+    double get_traversal_time() const { return t_traversal; }
+    double get_repair_time() const { return t_repair; }
+    double get_smooth_time() const { return t_smooth; }
+
+    index_t get_n_polygons() const { return m_polygons; }
+    index_t get_n_barrier_edge_tips() const { return n_barrier_edge_tips; }
+    index_t get_n_polygons_to_repair() const { return n_polygons_to_repair; }
+
+    //Index in the input of the vertex v of get_polygon_mesh(), v unless the input was reordered
+    index_t get_input_vertex(const index_t v) const { return mesh_input->original_vertex(v); }
+
+    //Evaluate the quality measures over the polygons of the mesh, each measure is evaluated in parallel
+    void compute_quality_measures(){
+        PhaseScope phase("quality");
+        quality_measures.clear();
+        quality_measures.emplace_back(new EdgeLengthRatio(mesh_output, output_seeds));
+        quality_measures.emplace_back(new MinAngle(mesh_output, output_seeds));
+        quality_measures.emplace_back(new MaxAngle(mesh_output, output_seeds));
+        quality_measures.emplace_back(new KernelAreaRatio(mesh_output, output_seeds));
+        quality_measures.emplace_back(new APR(mesh_output, output_seeds));
+        for (auto &measure : quality_measures) {
+            measure->eval_mesh();
+            progress()<<"Quality "<<measure->name()<<": min "<<measure->getMin()<<", max "<<measure->getMax()<<", avg "<<measure->getAverage()<<std::endl;
+        }
     }
 
 
     void print_stats(std::string filename){
+        TraceScope trace("print_stats");
         //Time
-        std::cout<<"Time to generate Triangulation: "<<mesh_input->get_triangulation_generation_time()<<" ms"<<std::endl;
-        std::cout<<"Time to label max edges "<<t_label_max_edges<<" ms"<<std::endl;
-        std::cout<<"Time to label frontier edges "<<t_label_frontier_edges<<" ms"<<std::endl;
-        std::cout<<"Time to label seed edges "<<t_label_seed_edges<<" ms"<<std::endl;
-        std::cout<<"Time to label total "<<t_label_max_edges+t_label_frontier_edges+t_label_seed_edges<<" ms"<<std::endl;
-        std::cout<<"Time to traversal and repair "<<t_traversal_and_repair<<" ms"<<std::endl;
-        std::cout<<"Time to traversal "<<t_traversal<<" ms"<<std::endl;
-        std::cout<<"Time to repair "<<t_repair<<" ms"<<std::endl;
-        std::cout<<"Time to smooth "<<t_smooth<<" ms"<<std::endl;
-        std::cout<<"Time to generate polygonal mesh "<<t_label_max_edges + t_label_frontier_edges + t_label_seed_edges + t_traversal_and_repair + t_smooth<<" ms"<<std::endl;
+        progress()<<"Time to read input: "<<mesh_input->get_read_input_time()<<" ms"<<std::endl;
+        progress()<<"Time to generate Triangulation: "<<mesh_input->get_triangulation_generation_time()<<" ms"<<std::endl;
+        const pipelined_read_stats &pipelined = mesh_input->get_pipelined_read();
+        if (pipelined.total > 0)
+            progress()<<"Pipelined read and construction: "<<pipelined.total<<" ms, overlap "<<100*pipelined.overlap()<<"%"<<std::endl;
+        progress()<<"Time to label max edges "<<t_label_max_edges<<" ms"<<std::endl;
+        progress()<<"Time to label frontier edges "<<t_label_frontier_edges<<" ms"<<std::endl;
+        progress()<<"Time to label seed edges "<<t_label_seed_edges<<" ms"<<std::endl;
+        progress()<<"Time to label total "<<t_label_max_edges+t_label_frontier_edges+t_label_seed_edges<<" ms"<<std::endl;
+        progress()<<"Time to traversal and repair "<<t_traversal_and_repair<<" ms"<<std::endl;
+        progress()<<"Time to traversal "<<t_traversal<<" ms"<<std::endl;
+        progress()<<"Time to repair "<<t_repair<<" ms"<<std::endl;
+        progress()<<"Time to smooth "<<t_smooth<<" ms"<<std::endl;
+        progress()<<"Time to generate polygonal mesh "<<t_label_max_edges + t_label_frontier_edges + t_label_seed_edges + t_traversal_and_repair + t_smooth<<" ms"<<std::endl;
 
         //Memory
         long long m_max_edges =  sizeof(decltype(max_edges.back())) * max_edges.capacity();
@@ -321,7 +563,7 @@ public:
         long long m_vertices_output = mesh_output->get_size_vertex_struct();
 
         std::ofstream out(filename);
-        std::cout<<"Printing JSON file as "<<filename<<std::endl;
+        progress()<<"Printing JSON file as "<<filename<<std::endl;
         out<<"{"<<std::endl;
         out<<"\"n_polygons\": "<<m_polygons<<","<<std::endl;
         out<<"\"n_frontier_edges\": "<<n_frontier_edges/2<<","<<std::endl;
@@ -332,7 +574,20 @@ public:
         out<<"\"n_polygons_to_repair\": "<<n_polygons_to_repair<<","<<std::endl;
         out<<"\"n_polygons_added_after_repair\": "<<n_polygons_added_after_repair<<","<<std::endl;
         out<<"\"n_smooth_iterations\": "<<n_smooth_iterations<<","<<std::endl;
+        out<<"\"time_to_read_input\": "<<mesh_input->get_read_input_time()<<","<<std::endl;
         out<<"\"time_triangulation_generation\": "<<mesh_input->get_triangulation_generation_time()<<","<<std::endl;
+        if (pipelined.total > 0) {
+            out<<"\"time_pipelined_read_node\": "<<pipelined.read_node<<","<<std::endl;
+            out<<"\"time_pipelined_read_ele\": "<<pipelined.read_ele<<","<<std::endl;
+            out<<"\"time_pipelined_read_neigh\": "<<pipelined.read_neigh<<","<<std::endl;
+            out<<"\"time_pipelined_build_interior\": "<<pipelined.build_interior<<","<<std::endl;
+            out<<"\"time_pipelined_total\": "<<pipelined.total<<","<<std::endl;
+            out<<"\"pipelined_read_overlap\": "<<pipelined.overlap()<<","<<std::endl;
+        }
+        if (!options.reorder.empty())
+            out<<"\"time_to_reorder\": "<<t_reorder<<","<<std::endl;
+        if (!options.sort_polygons.empty())
+            out<<"\"time_to_sort_polygons\": "<<t_sort_polygons<<","<<std::endl;
         out<<"\"time_to_label_max_edges\": "<<t_label_max_edges<<","<<std::endl;
         out<<"\"time_to_label_frontier_edges\": "<<t_label_frontier_edges<<","<<std::endl;
         out<<"\"time_to_label_seed_edges\": "<<t_label_seed_edges<<","<<std::endl;
@@ -340,8 +595,88 @@ public:
         out<<"\"time_to_traversal_and_repair\": "<<t_traversal_and_repair<<","<<std::endl;
         out<<"\"time_to_traversal\": "<<t_traversal<<","<<std::endl;
         out<<"\"time_to_repair\": "<<t_repair<<","<<std::endl;
+        if (n_polygons_to_repair > 0 && t_repair > 0)
+            out<<"\"repaired_polygons_per_second\": "<<n_polygons_to_repair / (t_repair / 1000)<<","<<std::endl;
         out<<"\"time_to_smooth\": "<<t_smooth<<","<<std::endl;
         out<<"\"time_to_generate_polygonal_mesh\": "<<t_label_max_edges + t_label_frontier_edges + t_label_seed_edges + t_traversal_and_repair + t_smooth<<","<<std::endl;
+        if (options.compute_kernels) {
+            out<<"\"time_to_kernel\": "<<t_kernel<<","<<std::endl;
+            out<<"\"n_star_shaped_polygons\": "<<n_star_shaped_polygons<<","<<std::endl;
+        }
+        if (!quality_measures.empty()) {
+            out<<"\"time_to_quality\": "<<t_quality<<","<<std::endl;
+            for (auto &measure : quality_measures) {
+                out<<"\"quality_"<<measure->name()<<"_min\": "<<measure->getMin()<<","<<std::endl;
+                out<<"\"quality_"<<measure->name()<<"_max\": "<<measure->getMax()<<","<<std::endl;
+                out<<"\"quality_"<<measure->name()<<"_avg\": "<<measure->getAverage()<<","<<std::endl;
+                out<<"\"quality_"<<measure->name()<<"_histogram\": [";
+                const std::vector<long long> &histogram = measure->getHistogram();
+                for (std::size_t i = 0; i < histogram.size(); i++)
+                    out<<(i > 0 ? ", " : "")<<histogram[i];
+                out<<"],"<<std::endl;
+            }
+        }
+        //Measured memory of the phases, the heap counters are available only with malloc_count
+        //and are omitted while other meshes are processed at the same time, which share them
+        MemoryStats &memory_stats = MemoryStats::instance();
+        for (const phase_memory &phase : memory_stats.phases()) {
+            if (MemoryStats::heap_available() && !memory_stats.concurrent()) {
+                out<<"\"memory_"<<phase.name<<"_peak_heap\": "<<phase.peak_heap<<","<<std::endl;
+                out<<"\"memory_"<<phase.name<<"_allocations\": "<<phase.allocations<<","<<std::endl;
+            }
+            if (phase.rss >= 0)
+                out<<"\"memory_"<<phase.name<<"_rss\": "<<phase.rss<<","<<std::endl;
+        }
+        if (MemoryStats::heap_available())
+            out<<"\"memory_peak_heap\": "<<memory_stats.peak_heap()<<","<<std::endl;
+        long long rss = MemoryStats::current_rss();
+        long long peak_rss = MemoryStats::peak_rss();
+        if (rss >= 0) out<<"\"memory_rss\": "<<rss<<","<<std::endl;
+        if (peak_rss >= 0) out<<"\"memory_peak_rss\": "<<peak_rss<<","<<std::endl;
+
+        //Backing of the vertex and half-edge arrays, memory_storage_<backing>_peak for each backing in use
+        ArrayStorage &storage = ArrayStorage::instance();
+        out<<"\"memory_storage\": \""<<ArrayStorage::mode_name(storage.mode())<<"\","<<std::endl;
+        for (int b = 0; b < N_STORAGE_BACKINGS; b++) {
+            const storage_mode backing = static_cast<storage_mode>(b);
+            if (storage.peak_bytes(backing) > 0)
+                out<<"\"memory_storage_"<<ArrayStorage::mode_name(backing)<<"_peak\": "<<storage.peak_bytes(backing)<<","<<std::endl;
+        }
+        long long huge_pages = ArrayStorage::anon_huge_page_bytes();
+        if (storage.mode() == STORAGE_HUGEPAGES && huge_pages >= 0)
+            out<<"\"memory_anon_huge_pages\": "<<huge_pages<<","<<std::endl;
+        //Blocks of the workspace when the mesh is processed inside a WorkspaceScope
+        if (const Workspace *workspace = storage.workspace()) {
+            out<<"\"workspace_blocks\": "<<workspace->blocks()<<","<<std::endl;
+            out<<"\"workspace_reused_blocks\": "<<workspace->reused_blocks()<<","<<std::endl;
+            out<<"\"workspace_bytes\": "<<workspace->bytes()<<","<<std::endl;
+        }
+
+        //Pinning of the threads and memory of the process on each NUMA node
+        NumaPlacement &numa = NumaPlacement::instance();
+        out<<"\"numa_pin\": \""<<NumaPlacement::pin_name(numa.pin())<<"\","<<std::endl;
+        const std::vector<long long> node_bytes = NumaPlacement::node_bytes();
+        for (std::size_t node = 0; node < node_bytes.size(); node++) {
+            progress()<<"Memory on NUMA node "<<node<<": "<<node_bytes[node] / (1024.0 * 1024.0)<<" MB"<<std::endl;
+            out<<"\"numa_node_"<<node<<"_bytes\": "<<node_bytes[node]<<","<<std::endl;
+        }
+
+        //Hardware counters of the phases, IPC and misses per half-edge
+        PerfCounters &perf = PerfCounters::instance();
+        if (perf.is_requested()) {
+            out<<"\"perf_counters_available\": "<<(perf.is_enabled() ? "true" : "false")<<","<<std::endl;
+            const double n_half_edges = mesh_input->halfEdges();
+            for (const phase_counters &phase : perf.phases()) {
+                for (int e = 0; e < N_PERF_EVENTS; e++)
+                    if (perf.event_available(static_cast<perf_event_kind>(e)))
+                        out<<"\"perf_"<<phase.name<<"_"<<PerfCounters::event_name(static_cast<perf_event_kind>(e))<<"\": "<<phase.values[e]<<","<<std::endl;
+                if (perf.event_available(PERF_CYCLES) && perf.event_available(PERF_INSTRUCTIONS) && phase.values[PERF_CYCLES] > 0)
+                    out<<"\"perf_"<<phase.name<<"_ipc\": "<<static_cast<double>(phase.values[PERF_INSTRUCTIONS]) / phase.values[PERF_CYCLES]<<","<<std::endl;
+                for (perf_event_kind e : {PERF_LLC_MISSES, PERF_BRANCH_MISSES, PERF_DTLB_MISSES})
+                    if (perf.event_available(e) && n_half_edges > 0)
+                        out<<"\"perf_"<<phase.name<<"_"<<PerfCounters::event_name(e)<<"_per_half_edge\": "<<phase.values[e] / n_half_edges<<","<<std::endl;
+            }
+        }
         out<<"\t\"memory_max_edges\": "<<m_max_edges<<","<<std::endl;
         out<<"\t\"memory_frontier_edge\": "<<m_frontier_edge<<","<<std::endl;
         out<<"\t\"memory_seed_edges\": "<<m_seed_edges<<","<<std::endl;
@@ -357,61 +692,179 @@ public:
     }
 
 
+    //Return the polygon mesh as CSR arrays, in the order of print_OFF, without writing any file
+    //The arrays are built in a single parallel pass over the polygons: each thread walks a contiguous
+    //range of polygons into its own buffers and then copies them to its place in the output
+    PolygonMesh get_polygon_mesh() {
+        TraceScope trace("get_polygon_mesh");
+        PolygonMesh polygon_mesh;
+        Triangulation* coord_mesh = (!options.smooth_method.empty()) ? mesh_output : mesh_input;
+
+        int n_threads = 1;
+#ifdef _OPENMP
+        n_threads = omp_get_max_threads();
+#endif
+        std::vector<long long> thread_size(n_threads + 1, 0);
+        polygon_mesh.polygon_offsets.resize(m_polygons + 1);
+        polygon_mesh.polygon_offsets[0] = 0;
+        if (options.use_regions)
+            polygon_mesh.polygon_region.resize(m_polygons);
+
+        #pragma omp parallel num_threads(n_threads)
+        {
+            TraceScope trace_thread("get_polygon_mesh_thread");
+            int t = 0, n_team = 1;
+#ifdef _OPENMP
+            t = omp_get_thread_num();
+            n_team = omp_get_num_threads();
+#endif
+            const index_t begin = static_cast<index_t>(static_cast<long long>(m_polygons) * t / n_team);
+            const index_t end = static_cast<index_t>(static_cast<long long>(m_polygons) * (t + 1) / n_team);
+            std::vector<index_t> local_vertices;
+            for (index_t i = begin; i < end; i++) {
+                index_t e_init = output_seeds[i];
+                index_t e_curr = e_init;
+                do {
+                    local_vertices.push_back(mesh_output->origin(e_curr));
+                    e_curr = mesh_output->next(e_curr);
+                } while (e_curr != e_init);
+                polygon_mesh.polygon_offsets[i + 1] = local_vertices.size(); //local offset, shifted below
+                if (options.use_regions)
+                    polygon_mesh.polygon_region[i] = mesh_input->region_face(mesh_input->index_face(e_init));
+            }
+            thread_size[t + 1] = local_vertices.size();
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                for (int k = 0; k < n_team; k++)
+                    thread_size[k + 1] += thread_size[k];
+                polygon_mesh.polygon_vertices.resize(thread_size[n_team]);
+            }
+
+            const long long shift = thread_size[t];
+            for (index_t i = begin; i < end; i++)
+                polygon_mesh.polygon_offsets[i + 1] += shift;
+            std::copy(local_vertices.begin(), local_vertices.end(), polygon_mesh.polygon_vertices.begin() + shift);
+        }
+
+        static_assert(sizeof(vertex) % sizeof(double) == 0, "vertex must be a whole number of doubles");
+        const vertex *vertices = coord_mesh->get_Vertices();
+        polygon_mesh.coordinates.x = vertices ? &vertices[0].x : nullptr;
+        polygon_mesh.coordinates.y = vertices ? &vertices[0].y : nullptr;
+        polygon_mesh.coordinates.stride = sizeof(vertex) / sizeof(double);
+        polygon_mesh.coordinates.n_vertices = coord_mesh->vertices();
+        return polygon_mesh;
+    }
+
+    //Polygon of each triangle, with the polygon indices of print_OFF and get_polygon_mesh()
+    //Each polygon collects its triangles from the triangle of its seed across the edges that are not
+    //frontier edges, the polygons are disjoint so they are walked in parallel
+    std::vector<index_t> get_triangle_polygons() {
+        TraceScope trace("get_triangle_polygons");
+        std::vector<index_t> triangle_polygon(mesh_input->faces(), -1);
+        #pragma omp parallel
+        {
+            std::vector<index_t> stack;
+            #pragma omp for schedule(dynamic, 1024)
+            for (index_t i = 0; i < m_polygons; i++) {
+                const index_t f_seed = mesh_input->index_face(output_seeds[i]);
+                triangle_polygon[f_seed] = i;
+                stack.push_back(f_seed);
+                while (!stack.empty()) {
+                    const index_t f = stack.back();
+                    stack.pop_back();
+                    for (index_t e = mesh_input->incident_halfedge(f); e < mesh_input->incident_halfedge(f) + 3; e++) {
+                        if (frontier_edges[e]) continue;
+                        const index_t g = mesh_input->index_face(mesh_input->twin(e));
+                        if (triangle_polygon[g] != -1) continue;
+                        triangle_polygon[g] = i;
+                        stack.push_back(g);
+                    }
+                }
+            }
+        }
+        return triangle_polygon;
+    }
+
+    //Print the kernel of each polygon, one line per polygon in the order of print_OFF:
+    //kernel area ratio and 1 if the polygon is star-shaped, 0 otherwise
+    void print_kernels(std::string filename){
+        TraceScope trace("print_kernels");
+        std::ofstream out(filename);
+        out<<std::setprecision(15);
+        for (index_t i = 0; i < m_polygons; i++)
+            out<<kernel_area_ratio[i]<<" "<<(star_shaped[i] ? 1 : 0)<<std::endl;
+        out.close();
+    }
+
     //Print ale file of the polylla mesh
     void print_ALE(std::string filename){
-        std::ofstream out(filename);
-        _polygon poly;
+        TraceScope trace("print_ALE");
+        std::ofstream out(filename, std::ios::binary);
         
         // Use mesh_output coordinates when smoothing is enabled, mesh_input otherwise
         Triangulation* coord_mesh = (!options.smooth_method.empty()) ? mesh_output : mesh_input;
         
-        out<<"# domain type\nCustom\n";
-        out<<"# nodal coordinates: number of nodes followed by the coordinates \n";
-        out<<coord_mesh->vertices()<<std::endl;
+        TextBuffer header;
+        header.append("# domain type\nCustom\n");
+        header.append("# nodal coordinates: number of nodes followed by the coordinates \n");
+        header.append(coord_mesh->vertices());
+        header.append('\n');
+        header.write(out);
         //print nodes
-        for(std::size_t v = 0; v < coord_mesh->vertices(); v++)
-            out<<std::setprecision(15)<<coord_mesh->get_PointX(v)<<" "<<coord_mesh->get_PointY(v)<<std::endl; 
-        out<<"# element connectivity: number of elements followed by the elements\n";
-        out<<this->m_polygons<<std::endl;
+        write_parallel(out, coord_mesh->vertices(), [&](TextBuffer &buffer, long long v){
+            buffer.append(coord_mesh->get_PointX(output_vertex(v)));
+            buffer.append(' ');
+            buffer.append(coord_mesh->get_PointY(output_vertex(v)));
+            buffer.append('\n');
+        });
+        header.clear();
+        header.append("# element connectivity: number of elements followed by the elements\n");
+        header.append(this->m_polygons);
+        header.append('\n');
+        header.write(out);
         //print polygons
-        int size_poly;
-        int e_curr;
-        for(auto &e_init : output_seeds){
-            size_poly = 1;
-            e_curr = mesh_output->next(e_init);
+        write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long i){
+            index_t e_init = output_seeds[i];
+            int size_poly = 1;
+            index_t e_curr = mesh_output->next(e_init);
             while(e_init != e_curr){
                 size_poly++;
                 e_curr = mesh_output->next(e_curr);
             }
-            out<<size_poly<<" ";            
-
-            out<<mesh_output->origin(e_init)<<" ";
-            e_curr = mesh_output->next(e_init);
-            while(e_init != e_curr){
-                out<<mesh_output->origin(e_curr)<<" ";
+            buffer.append(size_poly);
+            buffer.append(' ');
+            e_curr = e_init;
+            do {
+                buffer.append(output_index(mesh_output->origin(e_curr)));
+                buffer.append(' ');
                 e_curr = mesh_output->next(e_curr);
-            }
-            out<<std::endl; 
-        }
+            } while(e_init != e_curr);
+            buffer.append('\n');
+        });
         //Print borderedges
-        out<<"# indices of nodes located on the Dirichlet boundary\n";
+        TextBuffer footer;
+        footer.append("# indices of nodes located on the Dirichlet boundary\n");
         ///Find borderedges
-        int b_curr, b_init = 0;
+        index_t b_curr, b_init = 0;
         for(std::size_t i = mesh_input->halfEdges()-1; i != 0; i--){
             if(mesh_input->is_border_face(i)){
                 b_init = i;
                 break;
             }
         }
-        out<<mesh_input->origin(b_init)<<" ";
+        footer.append(output_index(mesh_input->origin(b_init)));
+        footer.append(' ');
         b_curr = mesh_input->prev(b_init);
         while(b_init != b_curr){
-            out<<mesh_input->origin(b_curr)<<" ";
+            footer.append(output_index(mesh_input->origin(b_curr)));
+            footer.append(' ');
             b_curr = mesh_input->prev(b_curr);
         }
-        out<<std::endl;
-        out<<"# indices of nodes located on the Neumann boundary\n0\n";
-        out<<"# xmin, xmax, ymin, ymax of the bounding box\n";
+        footer.append('\n');
+        footer.append("# indices of nodes located on the Neumann boundary\n0\n");
+        footer.append("# xmin, xmax, ymin, ymax of the bounding box\n");
         double xmax = mesh_input->get_PointX(0);
         double xmin = mesh_input->get_PointX(0);
         double ymax = mesh_input->get_PointY(0);
@@ -429,41 +882,62 @@ public:
             if(mesh_input->get_PointY(v) < ymin )
                 ymin = mesh_input->get_PointY(v);
         }
-        out<<xmin<<" "<<xmax<<" "<<ymin<<" "<<ymax<<std::endl;
+        footer.append(xmin); footer.append(' ');
+        footer.append(xmax); footer.append(' ');
+        footer.append(ymin); footer.append(' ');
+        footer.append(ymax); footer.append('\n');
+        footer.write(out);
         out.close();
     }
 
     //Print off file of the polylla mesh
     void print_OFF(std::string filename) {
-        std::ofstream out(filename);
+        std::ofstream out(filename, std::ios::binary);
+        print_OFF(out);
+    }
+
+    //Vertices and polygons are formatted in parallel and written in order, see buffered_writer.hpp
+    void print_OFF(std::ostream &out) {
+        TraceScope trace("print_OFF");
         
         // Use mesh_output coordinates when smoothing is enabled, mesh_input otherwise
         Triangulation* coord_mesh = (!options.smooth_method.empty()) ? mesh_output : mesh_input;
 
-        out << "OFF" << std::endl;
-        out << std::setprecision(15) << coord_mesh->vertices() << " " << m_polygons << " " << n_frontier_edges / 2 << std::endl;
+        TextBuffer header;
+        header.append("OFF\n");
+        header.append(coord_mesh->vertices());
+        header.append(' ');
+        header.append(m_polygons);
+        header.append(' ');
+        header.append(n_frontier_edges / 2);
+        header.append('\n');
+        header.write(out);
 
         // Print vertices
-        for (int i = 0; i < coord_mesh->vertices(); i++) {
-            out << coord_mesh->get_PointX(i) << " " << coord_mesh->get_PointY(i) << " 0" << std::endl;
-        }
+        write_parallel(out, coord_mesh->vertices(), [&](TextBuffer &buffer, long long i){
+            buffer.append(coord_mesh->get_PointX(output_vertex(i)));
+            buffer.append(' ');
+            buffer.append(coord_mesh->get_PointY(output_vertex(i)));
+            buffer.append(" 0\n");
+        });
 
         // Print polygons
-        for (int i = 0; i < m_polygons; i++) {
-            int e_init = output_seeds[i];
-            int e_curr = e_init;
-            std::vector<int> polygon_vertices;
-
-            // Collect vertex indices of the polygon
+        write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long i){
+            index_t e_init = output_seeds[i];
+            index_t e_curr = e_init;
+            int size_poly = 0;
             do {
-                polygon_vertices.push_back(mesh_output->origin(e_curr));
+                size_poly++;
                 e_curr = mesh_output->next(e_curr);
             } while (e_curr != e_init);
 
             // Write polygon
-            out << polygon_vertices.size();
-            for (int v : polygon_vertices)
-                out << " " << v;
+            buffer.append(size_poly);
+            do {
+                buffer.append(' ');
+                buffer.append(output_index(mesh_output->origin(e_curr)));
+                e_curr = mesh_output->next(e_curr);
+            } while (e_curr != e_init);
                 
             // Add colors only if using regions
             if (options.use_regions) {
@@ -475,20 +949,219 @@ public:
                 float g = (region * 149 % 256) / 255.0f;
                 float b = (region * 233 % 256) / 255.0f;
 
-                out << " " << r << " " << g << " " << b << " 1.0";
+                buffer.append(' '); buffer.append(r);
+                buffer.append(' '); buffer.append(g);
+                buffer.append(' '); buffer.append(b);
+                buffer.append(" 1.0");
             }
-            out << std::endl;
+            buffer.append('\n');
+        });
+        out.flush();
+    }
+
+    //Print vtu file of the polylla mesh, VTK XML unstructured grid with the arrays appended as raw binary
+    void print_VTU(std::string filename) {
+        std::ofstream out(filename, std::ios::binary);
+        print_VTU(out);
+    }
+
+    //The region of each polygon is added as cell data when using regions
+    void print_VTU(std::ostream &out) {
+        TraceScope trace("print_VTU");
+        Triangulation* coord_mesh = (!options.smooth_method.empty()) ? mesh_output : mesh_input;
+
+        std::vector<long long> offsets;
+        polygon_offsets(offsets);
+        const long long n_vertices = coord_mesh->vertices();
+        const long long n_connectivity = offsets[m_polygons];
+
+        //Byte offset of each array in the appended data, every array is preceded by its UInt64 size
+        const std::uint64_t size_points = 3 * sizeof(double) * n_vertices;
+        const std::uint64_t size_connectivity = sizeof(index_t) * n_connectivity;
+        const std::uint64_t size_offsets = sizeof(std::int64_t) * m_polygons;
+        const std::uint64_t size_types = sizeof(std::uint8_t) * m_polygons;
+        const std::uint64_t size_regions = sizeof(std::int32_t) * m_polygons;
+        const std::uint64_t offset_points = 0;
+        const std::uint64_t offset_connectivity = offset_points + sizeof(std::uint64_t) + size_points;
+        const std::uint64_t offset_offsets = offset_connectivity + sizeof(std::uint64_t) + size_connectivity;
+        const std::uint64_t offset_types = offset_offsets + sizeof(std::uint64_t) + size_offsets;
+        const std::uint64_t offset_regions = offset_types + sizeof(std::uint64_t) + size_types;
+
+        TextBuffer header;
+        header.append("<?xml version=\"1.0\"?>\n");
+        header.append("<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\">\n");
+        header.append("  <UnstructuredGrid>\n");
+        header.append("    <Piece NumberOfPoints=\""); header.append(n_vertices);
+        header.append("\" NumberOfCells=\""); header.append(m_polygons); header.append("\">\n");
+        header.append("      <Points>\n");
+        header.append("        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"");
+        header.append(static_cast<std::size_t>(offset_points)); header.append("\"/>\n");
+        header.append("      </Points>\n");
+        header.append("      <Cells>\n");
+        header.append(INDEX_BITS == 64 ? "        <DataArray type=\"Int64\"" : "        <DataArray type=\"Int32\"");
+        header.append(" Name=\"connectivity\" format=\"appended\" offset=\"");
+        header.append(static_cast<std::size_t>(offset_connectivity)); header.append("\"/>\n");
+        header.append("        <DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" offset=\"");
+        header.append(static_cast<std::size_t>(offset_offsets)); header.append("\"/>\n");
+        header.append("        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"");
+        header.append(static_cast<std::size_t>(offset_types)); header.append("\"/>\n");
+        header.append("      </Cells>\n");
+        if (options.use_regions) {
+            header.append("      <CellData Scalars=\"region\">\n");
+            header.append("        <DataArray type=\"Int32\" Name=\"region\" format=\"appended\" offset=\"");
+            header.append(static_cast<std::size_t>(offset_regions)); header.append("\"/>\n");
+            header.append("      </CellData>\n");
         }
+        header.append("    </Piece>\n");
+        header.append("  </UnstructuredGrid>\n");
+        header.append("  <AppendedData encoding=\"raw\">\n   _");
+        header.write(out);
+
+        TextBuffer size;
+        size.append_binary(size_points);
+        size.write(out);
+        write_parallel(out, n_vertices, [&](TextBuffer &buffer, long long v){
+            buffer.append_binary(coord_mesh->get_PointX(output_vertex(v)));
+            buffer.append_binary(coord_mesh->get_PointY(output_vertex(v)));
+            buffer.append_binary(0.0);
+        });
+
+        size.clear();
+        size.append_binary(size_connectivity);
+        size.write(out);
+        write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long i){
+            index_t e_init = output_seeds[i];
+            index_t e_curr = e_init;
+            do {
+                buffer.append_binary(static_cast<index_t>(output_index(mesh_output->origin(e_curr))));
+                e_curr = mesh_output->next(e_curr);
+            } while (e_curr != e_init);
+        });
+
+        size.clear();
+        size.append_binary(size_offsets);
+        size.write(out);
+        write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long i){
+            buffer.append_binary(static_cast<std::int64_t>(offsets[i + 1]));
+        });
+
+        size.clear();
+        size.append_binary(size_types);
+        size.write(out);
+        write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long){
+            buffer.append_binary(static_cast<std::uint8_t>(VTK_POLYGON));
+        });
 
-        out.close();
+        if (options.use_regions) {
+            size.clear();
+            size.append_binary(size_regions);
+            size.write(out);
+            write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long i){
+                buffer.append_binary(static_cast<std::int32_t>(mesh_input->region_face(mesh_input->index_face(output_seeds[i]))));
+            });
+        }
+
+        TextBuffer footer;
+        footer.append("\n  </AppendedData>\n</VTKFile>\n");
+        footer.write(out);
+        out.flush();
+    }
+
+    //Print binary little-endian ply file of the polylla mesh, each face is a variable-length list of vertices
+    void print_PLY(std::string filename) {
+        std::ofstream out(filename, std::ios::binary);
+        print_PLY(out);
+    }
+
+    //The region of each polygon is added as a face property when using regions
+    void print_PLY(std::ostream &out) {
+        TraceScope trace("print_PLY");
+        Triangulation* coord_mesh = (!options.smooth_method.empty()) ? mesh_output : mesh_input;
+        //PLY has no 64-bit integers, the vertex indices are written as int
+        if (coord_mesh->vertices() > std::numeric_limits<std::int32_t>::max())
+            throw std::runtime_error("PLY vertex indices are 32-bit, use the OFF or VTU output for this mesh");
+
+        std::vector<long long> offsets;
+        polygon_offsets(offsets);
+        long long max_size = 0;
+        for (index_t i = 0; i < m_polygons; i++)
+            max_size = std::max(max_size, offsets[i + 1] - offsets[i]);
+        const bool uchar_count = max_size < 256; //uchar list counts are the most portable
+
+        TextBuffer header;
+        header.append("ply\n");
+        header.append("format binary_little_endian 1.0\n");
+        header.append("element vertex "); header.append(coord_mesh->vertices()); header.append('\n');
+        header.append("property double x\n");
+        header.append("property double y\n");
+        header.append("property double z\n");
+        header.append("element face "); header.append(m_polygons); header.append('\n');
+        header.append(uchar_count ? "property list uchar int vertex_indices\n" : "property list int int vertex_indices\n");
+        if (options.use_regions)
+            header.append("property int region\n");
+        header.append("end_header\n");
+        header.write(out);
+
+        write_parallel(out, coord_mesh->vertices(), [&](TextBuffer &buffer, long long v){
+            buffer.append_binary(coord_mesh->get_PointX(output_vertex(v)));
+            buffer.append_binary(coord_mesh->get_PointY(output_vertex(v)));
+            buffer.append_binary(0.0);
+        });
+
+        write_parallel(out, m_polygons, [&](TextBuffer &buffer, long long i){
+            long long size_poly = offsets[i + 1] - offsets[i];
+            if (uchar_count)
+                buffer.append_binary(static_cast<std::uint8_t>(size_poly));
+            else
+                buffer.append_binary(static_cast<std::int32_t>(size_poly));
+            index_t e_init = output_seeds[i];
+            index_t e_curr = e_init;
+            do {
+                buffer.append_binary(static_cast<std::int32_t>(output_index(mesh_output->origin(e_curr))));
+                e_curr = mesh_output->next(e_curr);
+            } while (e_curr != e_init);
+            if (options.use_regions)
+                buffer.append_binary(static_cast<std::int32_t>(mesh_input->region_face(mesh_input->index_face(e_init))));
+        });
+        out.flush();
     }
 
 private:
 
+    //Index of the vertex v in the outputs, its input index when the input order is restored
+    index_t output_index(const index_t v) const {
+        return vertex_of_line.empty() ? v : mesh_input->original_vertex(v);
+    }
+
+    //Vertex written at the line of the outputs
+    index_t output_vertex(const long long line) const {
+        return vertex_of_line.empty() ? static_cast<index_t>(line) : vertex_of_line[line];
+    }
+
+    //Compute the offsets of the polygons in a flat list of their vertices,
+    //polygon i has the vertices [offsets[i], offsets[i+1])
+    void polygon_offsets(std::vector<long long> &offsets) {
+        offsets.assign(m_polygons + 1, 0);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < m_polygons; i++) {
+            index_t e_init = output_seeds[i];
+            index_t e_curr = e_init;
+            long long size_poly = 0;
+            do {
+                size_poly++;
+                e_curr = mesh_output->next(e_curr);
+            } while (e_curr != e_init);
+            offsets[i + 1] = size_poly;
+        }
+        for (index_t i = 0; i < m_polygons; i++)
+            offsets[i + 1] += offsets[i];
+    }
+
+
     //Return true if it is the edge is terminal-edge or terminal border edge, 
     //but it only selects one halfedge as terminal-edge, the halfedge with lowest index is selected
-    bool is_seed_edge(int e){
-        int twin = mesh_input->twin(e);
+    bool is_seed_edge(index_t e){
+        index_t twin = mesh_input->twin(e);
 
         bool is_terminal_edge = (mesh_input->is_interior_face(twin) && (max_edges[e] && max_edges[twin]));
         bool is_terminal_border_edge = (mesh_input->is_border_face(twin) && max_edges[e]);
@@ -514,13 +1187,13 @@ private:
     //Label max edges of all triangles in the triangulation
     //input: edge e indicent to a triangle t
     //output: position of edge e in max_edges[e] is labeled as true
-    int label_max_edge(const int e)
+    index_t label_max_edge(const index_t e)
     {
         //Calculates the size of each edge of a triangle
         if (mesh_input == nullptr) return e;
         
-        int e_next = mesh_input->next(e);
-        int e_prev = mesh_input->prev(e);
+        index_t e_next = mesh_input->next(e);
+        index_t e_prev = mesh_input->prev(e);
         double dist0 = mesh_input->distance(e);
         double dist1 = mesh_input->distance(e_next);
         double dist2 = mesh_input->distance(e_prev);
@@ -537,9 +1210,9 @@ private:
  
     //Return true if the edge e is the lowest edge both triangles incident to e
     //in case of border edges, they are always labeled as frontier-edge
-    bool is_frontier_edge(const int e)
+    bool is_frontier_edge(const index_t e)
     {
-        int twin = mesh_input->twin(e);
+        index_t twin = mesh_input->twin(e);
         bool is_border_edge = mesh_input->is_border_face(e) || mesh_input->is_border_face(twin);
         bool is_not_max_edge = !(max_edges[e] || max_edges[twin]);
 
@@ -550,18 +1223,18 @@ private:
     }
 
     //Travel in CCW order around the edges of vertex v from the edge e looking for the next frontier edge
-    int search_frontier_edge(const int e)
+    index_t search_frontier_edge(const index_t e)
     {
-        int nxt = e;
+        index_t nxt = e;
         while(!frontier_edges[nxt])
             nxt = mesh_input->CW_edge_to_vertex(nxt);
         return nxt;
     }
 
     //return true if the polygon is not simple
-    bool has_BarrierEdgeTip(int e_init){
+    bool has_BarrierEdgeTip(index_t e_init){
 
-        int e_curr = mesh_output->next(e_init);
+        index_t e_curr = mesh_output->next(e_init);
         //travel inside frontier-edges of polygon
         while(e_curr != e_init){   
             //if the twin of the next halfedge is the current halfedge, then the polygon is not simple
@@ -576,12 +1249,12 @@ private:
     //generate a polygon from a seed edge
     //input: Seed-edge
     //Output: seed frontier-edge of new popygon
-    int travel_triangles(const int e)
+    index_t travel_triangles(const index_t e)
     {   
         //search next frontier-edge
-        int e_init = search_frontier_edge(e);
-        int e_curr = mesh_input->next(e_init);        
-        int e_fe = e_init; 
+        index_t e_init = search_frontier_edge(e);
+        index_t e_curr = mesh_input->next(e_init);        
+        index_t e_fe = e_init; 
         // std::cout << "new" <<std::endl;
         //travel inside frontier-edges of polygon
         do{   
@@ -591,8 +1264,8 @@ private:
             //update prev of current frontier-edge
             mesh_output->set_prev(e_curr, e_fe);
 
-            int v_curr = mesh_input->target(e_fe);
-            int e_incident = mesh_input->twin(e_fe);
+            index_t v_curr = mesh_input->target(e_fe);
+            index_t e_incident = mesh_input->twin(e_fe);
             // std::cout << "travelling "<< v_curr << "-"<< std::endl;
             // if (v_curr == 8||v_curr == 5||v_curr == 9||v_curr == 12||v_curr == 10||v_curr == 38||v_curr == 14) {
             //     std::cout << "v " << v_curr << "e " <<e_incident << std::endl;
@@ -610,11 +1283,11 @@ private:
     //The function first calculate the degree of v - 1 and then divide it by 2, after travel to until the middle-edge
     //input: vertex v
     //output: edge incident to v
-    int calculate_middle_edge(const int v){
-        int frontieredge_with_bet = this->search_frontier_edge(mesh_input->edge_of_vertex(v));
+    index_t calculate_middle_edge(const index_t v){
+        index_t frontieredge_with_bet = this->search_frontier_edge(mesh_input->edge_of_vertex(v));
         int internal_edges =mesh_input->degree(v) - 1; //internal-edges incident to v
         int adv = (internal_edges%2 == 0) ? internal_edges/2 - 1 : internal_edges/2 ;
-        int nxt = mesh_input->CW_edge_to_vertex(frontieredge_with_bet);
+        index_t nxt = mesh_input->CW_edge_to_vertex(frontieredge_with_bet);
         //back to traversing the edges of v_bet until select the middle-edge
         while (adv != 0){
             nxt = mesh_input->CW_edge_to_vertex(nxt);
@@ -626,15 +1299,15 @@ private:
     //Given a seed edge e that generated polygon, split the polygon until remove al barrier-edge tips
     //input: seed edge e, polygon poly
     //output: polygon without barrier-edge tips
-    void barrieredge_tip_reparation(const int e)
+    void barrieredge_tip_reparation(const index_t e)
     {
         this->n_polygons_to_repair++;
-        int x, y, i;
-        int t1, t2;
-        int middle_edge, v_bet;
+        index_t x, y, i;
+        index_t t1, t2;
+        index_t middle_edge, v_bet;
 
-        int e_init = e;
-        int e_curr = mesh_output->next(e_init);
+        index_t e_init = e;
+        index_t e_curr = mesh_output->next(e_init);
         //search by barrier-edge tips
         while(e_curr != e_init){   
             //if the twin of the next halfedge is the current halfedge, then the polygon is not simple
@@ -668,11 +1341,11 @@ private:
             e_curr = mesh_output->next(e_curr);
         }
 
-        int t_curr;
+        index_t t_curr;
         //generate polygons from seeds,
         //two seeds can generate the same polygon
         //so the bit_vector seed_bet_mark is used to label as false the edges that are already used
-        int new_polygon_seed;
+        index_t new_polygon_seed;
         while (!triangle_list.empty()){
             t_curr = triangle_list.back();
             triangle_list.pop_back();
@@ -738,9 +1411,9 @@ private:
     //Generate a polygon from a seed-edge and remove repeated seed from seed_list
     //POSIBLE BUG: el algoritmo no viaja por todos los halfedges dentro de un poligono, 
     //por lo que pueden haber semillas que no se borren y tener poligonos repetidos de output
-    int generate_repaired_polygon(const int e, bit_vector &seed_list)
+    index_t generate_repaired_polygon(const index_t e, bit_vector &seed_list)
     {   
-        int e_init = e;
+        index_t e_init = e;
 
         //search next frontier-edge
         while(!frontier_edges[e_init]){
@@ -748,10 +1421,10 @@ private:
             seed_list[e_init] = false; 
             //seed_list[mesh_input->twin(e_init)] = false;
         }   
-        int e_curr = mesh_input->next(e_init);    
+        index_t e_curr = mesh_input->next(e_init);    
         seed_list[e_curr] = false;
     
-        int e_fe = e_init; 
+        index_t e_fe = e_init; 
 
         //travel inside frontier-edges of polygon
         do{   
@@ -783,7 +1456,7 @@ private:
         return e_init;
     }
 
-    double area(int v0, int v1, int v2) {
+    double area(index_t v0, index_t v1, index_t v2) {
         double area =   (mesh_output->get_PointX(v1) - mesh_output->get_PointX(v0)) * 
                         (mesh_output->get_PointY(v2) - mesh_output->get_PointY(v0)) - 
                         (mesh_output->get_PointY(v1) - mesh_output->get_PointY(v0)) * 
@@ -791,11 +1464,11 @@ private:
         return area;
     }
 
-    bool is_left(int v0, int v1, int p) {
+    bool is_left(index_t v0, index_t v1, index_t p) {
         return area(v0, v1, p) > 0;
     }
 
-    bool parallel(int e1, int e2) {
+    bool parallel(index_t e1, index_t e2) {
         auto v0 = mesh_output->origin(e1);
         auto v1 = mesh_output->target(e1);
         auto v2 = mesh_output->origin(e2);
@@ -812,12 +1485,12 @@ private:
         return std::abs(den) < EPSILON;
     }
 
-    bool is_collinear(int v0, int v1, int v2) {
+    bool is_collinear(index_t v0, index_t v1, index_t v2) {
         double this_area = area(v0, v1, v2);
         return std::abs(this_area) < EPSILON;
     }
 
-    bool in_range(int p, int v0, int v1) {
+    bool in_range(index_t p, index_t v0, index_t v1) {
         auto p_x = mesh_output->get_PointX(p);
         auto p_y = mesh_output->get_PointY(p);
         auto v0_x = mesh_output->get_PointX(v0);
@@ -828,7 +1501,7 @@ private:
                 std::min(v0_y, v1_y) < p_y && p_y < std::max(v0_y, v1_y);
     }
 
-    bool intersection(int e1, int e2) {
+    bool intersection(index_t e1, index_t e2) {
         auto v0 = mesh_output->origin(e1);
         auto v1 = mesh_output->target(e1);
         auto v2 = mesh_output->origin(e2);
@@ -847,7 +1520,7 @@ private:
     //
     // This approach guarantees O(1) efficiency in average case when using precomputation,
     // while maintaining robustness through the fallback method.
-    bool is_region_boundary_vertex(int v) {
+    bool is_region_boundary_vertex(index_t v) {
         // 1. Initial verification: if not using regions, return false immediately
         if (!options.use_regions) return false;
         
@@ -869,7 +1542,7 @@ private:
             auto e_next = e_init;
             int first_region = -1;
             do {
-                int face = mesh_input->index_face(e_next);
+                index_t face = mesh_input->index_face(e_next);
                 if (face >= 0) {
                     int current_region = mesh_input->region_face(face);
                     if (first_region == -1) {
@@ -891,14 +1564,14 @@ private:
         
         region_boundary_edges.resize(mesh_input->halfEdges(), false);
         
-        for (int e = 0; e < mesh_input->halfEdges(); e++) {
+        for (index_t e = 0; e < mesh_input->halfEdges(); e++) {
             // Skip if already processed (twin was processed first)
             if (region_boundary_edges[e]) continue;
             
-            int twin = mesh_input->twin(e);
+            index_t twin = mesh_input->twin(e);
             if (twin >= 0) {
-                int face1 = mesh_input->index_face(e);
-                int face2 = mesh_input->index_face(twin);
+                index_t face1 = mesh_input->index_face(e);
+                index_t face2 = mesh_input->index_face(twin);
                 
                 if (face1 >= 0 && face2 >= 0) {
                     if (mesh_input->region_face(face1) != mesh_input->region_face(face2)) {
@@ -917,7 +1590,7 @@ private:
         
         if (!options.use_regions) return region_boundary_vertices;
         
-        for (int v = 0; v < mesh_input->vertices(); v++) {
+        for (index_t v = 0; v < mesh_input->vertices(); v++) {
             if (is_region_boundary_vertex(v)) {
                 region_boundary_vertices[v] = true;
             }
@@ -926,7 +1599,7 @@ private:
         return region_boundary_vertices;
     }
 
-    bool is_valid_move(int v) {
+    bool is_valid_move(index_t v) {
         auto e_init = mesh_input->edge_of_vertex(v);
         auto e_next = e_init;
         do {
@@ -992,6 +1665,7 @@ private:
         double first_movement = -1;
         
         for (int i = 0; i < max_iterations; i++) {
+            TraceScope trace("smoothing_iteration");
             n_smooth_iterations++;
             double movement = 0;
             for(std::size_t v = 0; v < mesh_output->vertices(); v++){
@@ -1033,16 +1707,126 @@ private:
         }
     }
 
+    // Laplacian smoothing solved directly as a sparse linear system.
+    // The fixed point of optimize_mesh_laplacian is deg(v)*p_v - sum(p_u) = 0 for each free vertex v,
+    // with border and region boundary vertices as Dirichlet conditions moved to the right hand side.
+    // The system is assembled once in CSR from the half-edge structure and solved with a Jacobi
+    // preconditioned conjugate gradient, max_iterations bounds the number of CG iterations.
+    void optimize_mesh_laplacian_cg(int max_iterations) {
+        const index_t n_vertices = mesh_output->vertices();
+
+        //Number the free vertices, the rest are fixed
+        std::vector<index_t> free_index(n_vertices, -1);
+        std::vector<index_t> free_vertices;
+        for (index_t v = 0; v < n_vertices; v++) {
+            if (mesh_output->is_border_vertex(v) || mesh_output->edge_of_vertex(v) < 0) continue;
+            if (options.use_regions && is_region_boundary_vertex(v)) continue;
+            free_index[v] = free_vertices.size();
+            free_vertices.push_back(v);
+        }
+        const index_t n_free = free_vertices.size();
+        if (n_free == 0) return;
+
+        //Row sizes: diagonal plus one entry per free neighbour
+        CSRMatrix L;
+        L.row_ptr.assign(n_free + 1, 0);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n_free; i++) {
+            index_t v = free_vertices[i];
+            index_t e_init = mesh_output->edge_of_vertex(v);
+            index_t e_next = e_init;
+            int entries = 1;
+            do {
+                if (free_index[mesh_output->target(e_next)] >= 0) entries++;
+                e_next = mesh_output->CCW_edge_to_vertex(e_next);
+            } while (e_next != e_init);
+            L.row_ptr[i + 1] = entries;
+        }
+        for (index_t i = 0; i < n_free; i++)
+            L.row_ptr[i + 1] += L.row_ptr[i];
+        L.col_idx.resize(L.row_ptr[n_free]);
+        L.values.resize(L.row_ptr[n_free]);
+
+        //Fill the matrix, fixed neighbours go to the right hand side
+        std::vector<double> x(n_free), y(n_free), bx(n_free, 0), by(n_free, 0);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n_free; i++) {
+            index_t v = free_vertices[i];
+            index_t e_init = mesh_output->edge_of_vertex(v);
+            index_t e_next = e_init;
+            index_t k = L.row_ptr[i] + 1;
+            int degree = 0;
+            do {
+                index_t u = mesh_output->target(e_next);
+                if (free_index[u] >= 0) {
+                    L.col_idx[k] = free_index[u];
+                    L.values[k] = -1;
+                    k++;
+                } else {
+                    bx[i] += mesh_output->get_PointX(u);
+                    by[i] += mesh_output->get_PointY(u);
+                }
+                degree++;
+                e_next = mesh_output->CCW_edge_to_vertex(e_next);
+            } while (e_next != e_init);
+            L.col_idx[L.row_ptr[i]] = i;
+            L.values[L.row_ptr[i]] = degree;
+            x[i] = mesh_output->get_PointX(v);
+            y[i] = mesh_output->get_PointY(v);
+        }
+
+        //Current positions are the initial guess
+        int it_x, it_y;
+        {
+            TraceScope trace("cg_solve");
+            it_x = conjugate_gradient(L, bx, x, max_iterations, CG_TOLERANCE);
+            it_y = conjugate_gradient(L, by, y, max_iterations, CG_TOLERANCE);
+        }
+        n_smooth_iterations += std::max(it_x, it_y);
+
+        if (!options.validate_moves) {
+            #pragma omp parallel for schedule(static)
+            for (index_t i = 0; i < n_free; i++) {
+                mesh_output->set_PointX(free_vertices[i], x[i]);
+                mesh_output->set_PointY(free_vertices[i], y[i]);
+            }
+            return;
+        }
+
+        //Optional validation pass: vertices are moved one by one and the move
+        //is undone if it generates intersecting edges
+        for (index_t i = 0; i < n_free; i++) {
+            index_t v = free_vertices[i];
+            double original_x = mesh_output->get_PointX(v);
+            double original_y = mesh_output->get_PointY(v);
+            mesh_output->set_PointX(v, x[i]);
+            mesh_output->set_PointY(v, y[i]);
+            if (!is_valid_move(v)) {
+                mesh_output->set_PointX(v, original_x);
+                mesh_output->set_PointY(v, original_y);
+            }
+        }
+    }
+
     void optimize_mesh_laplacian_constrained(int iterations, std::string measure_type) {
-        Measure* measure = nullptr;
         if (measure_type == "laplacian-edge-ratio") {
-            measure = new EdgeRatio(mesh_output, output_seeds);
+            EdgeRatio measure(mesh_output, output_seeds);
+            optimize_mesh_laplacian_with_measure(iterations, measure);
         } else {
             std::cerr << "Warning: Unknown measure type '" << measure_type << "'. Skipping optimization." << std::endl;
-            return;
         }
+    }
+
+    // Laplacian smoothing that only keeps the moves that do not worsen the measure M
+    // M is a StaticMeasure, so the face evaluations are inlined, and the values of the
+    // faces are cached, after a move only the faces incident to the moved vertex are refreshed
+    template <typename M>
+    void optimize_mesh_laplacian_with_measure(int iterations, const M &measure) {
+        MeasureCache<M> cache(measure, mesh_output);
+        std::vector<double> new_values;
         
         for (int i = 0; i<iterations; i++) {
+            TraceScope trace("smoothing_iteration");
             n_smooth_iterations++;
             for(std::size_t v = 0; v < mesh_output->vertices(); v++){
                 if (mesh_output->is_border_vertex(v) || mesh_output->edge_of_vertex(v) < 0) continue;   
@@ -1054,53 +1838,50 @@ private:
                 int n = 0;
                 double x = 0;
                 double y = 0;
+                // original measures
+                double original_sum = 0;
                 do {
                     auto v_next = mesh_output->target(e_next);
                     x += mesh_output->get_PointX(v_next) - mesh_output->get_PointX(v);
                     y += mesh_output->get_PointY(v_next) - mesh_output->get_PointY(v);
+                    original_sum += cache.eval_face(e_next);
                     n++;
                     e_next = mesh_output->CCW_edge_to_vertex(e_next);
                 } while (e_next != e_init);
-
-                // original measures
+                double original_avg = original_sum / n;
                 double original_x = mesh_output->get_PointX(v);
                 double original_y = mesh_output->get_PointY(v);
-                double original_sum = 0;
-                int adjacent_faces = 0;
-                e_init = mesh_output->edge_of_vertex(v);
-                e_next = e_init;
-                do {
-                    // double face_res = measure(mesh_output, e_next);
-                    double face_res = measure->eval_face(e_next);
-                    adjacent_faces++;
-                    original_sum += face_res;
-                    e_next = mesh_output->CCW_edge_to_vertex(e_next);
-                } while (e_next != e_init);
-                double original_avg = original_sum / adjacent_faces;
 
                 // move vertex
-                mesh_output->set_PointX(v, mesh_output->get_PointX(v) + x/n);
-                mesh_output->set_PointY(v, mesh_output->get_PointY(v) + y/n);
+                mesh_output->set_PointX(v, original_x + x/n);
+                mesh_output->set_PointY(v, original_y + y/n);
 
                 // new measures
                 double new_sum = 0;
+                new_values.clear();
                 e_next = e_init;
                 do {
-                    // double face_res = measure(mesh_output, e_next);
-                    double face_res = measure->eval_face(e_next);
+                    double face_res = measure.face_value(e_next);
+                    new_values.push_back(face_res);
                     new_sum += face_res;
                     e_next = mesh_output->CCW_edge_to_vertex(e_next);
                 } while (e_next != e_init);
-                double new_avg = new_sum / adjacent_faces;
+                double new_avg = new_sum / n;
 
-                // if worse measure undo move
-                if (measure->is_better(original_avg, new_avg) || !is_valid_move(v)) {
+                // if worse measure undo move, else refresh the faces incident to v
+                if (measure.better(original_avg, new_avg) || !is_valid_move(v)) {
                     mesh_output->set_PointX(v, original_x);
                     mesh_output->set_PointY(v, original_y);
+                } else {
+                    int k = 0;
+                    e_next = e_init;
+                    do {
+                        cache.store(e_next, new_values[k++]);
+                        e_next = mesh_output->CCW_edge_to_vertex(e_next);
+                    } while (e_next != e_init);
                 }
             }
         }
-        delete measure;
     }
     
     void optimize_mesh_distmesh(int max_iterations, double target_length) {
@@ -1120,6 +1901,7 @@ private:
         
         // std::cout << target_length << std::endl;
         for (int i = 0; i < max_iterations; i++) {
+            TraceScope trace("smoothing_iteration");
             n_smooth_iterations++;
             double movement = 0;
 
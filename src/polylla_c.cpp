@@ -0,0 +1,126 @@
+// C interface of Polylla, see polylla_c.h
+// The handle keeps the Polylla object alive, the CSR arrays are moved out of it once
+// The coordinates are copied into the packed xy array, the vertices of Polylla are strided structs
+
+#include <polylla_c.h>
+#include <polylla.hpp>
+#include <triangulation.hpp>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+struct polylla_mesh {
+    Polylla *polylla = nullptr;
+    PolygonMesh polygons;
+    std::vector<double> xy; //coordinates of the vertices after smoothing
+
+    ~polylla_mesh() { delete polylla; }
+};
+
+static_assert(sizeof(long long) == sizeof(int64_t), "polygon offsets are exposed as int64_t");
+static_assert(sizeof(index_t) == sizeof(int), "the C interface exposes the vertex indices as int, build it without POLYLLA_INDEX64");
+
+static thread_local std::string last_error;
+
+//The indices of the triangles are checked by the Triangulation constructor
+static void check_input(const double *xy, int nv, const int *tri, int nt) {
+    if (xy == nullptr || tri == nullptr)
+        throw std::invalid_argument("xy and tri can not be NULL");
+    if (nv < 3 || nt < 1)
+        throw std::invalid_argument("the triangulation needs at least 3 vertices and 1 triangle");
+}
+
+extern "C" {
+
+void polylla_default_options(polylla_options *options) {
+    PolyllaOptions defaults;
+    options->use_regions = defaults.use_regions;
+    options->smooth_method = nullptr;
+    options->smooth_iterations = defaults.smooth_iterations;
+    options->target_length = defaults.target_length;
+    options->validate_moves = defaults.validate_moves;
+}
+
+polylla_mesh *polylla_create(const double *xy, int nv, const int *tri, int nt,
+                             const int *neigh_or_null, const int *regions_or_null,
+                             const polylla_options *options) {
+    polylla_mesh *mesh = nullptr;
+    try {
+        check_input(xy, nv, tri, nt);
+
+        polylla_options c_options;
+        if (options != nullptr)
+            c_options = *options;
+        else
+            polylla_default_options(&c_options);
+
+        PolyllaOptions polylla_options;
+        polylla_options.progress = nullptr; //std::cout belongs to the host application
+        polylla_options.use_regions = c_options.use_regions != 0;
+        polylla_options.smooth_method = c_options.smooth_method != nullptr ? c_options.smooth_method : "";
+        polylla_options.smooth_iterations = c_options.smooth_iterations;
+        polylla_options.target_length = c_options.target_length;
+        polylla_options.validate_moves = c_options.validate_moves != 0;
+
+        const std::vector<std::string> valid_methods = {"", "laplacian", "laplacian-edge-ratio", "distmesh", "laplacian-cg"};
+        if (std::find(valid_methods.begin(), valid_methods.end(), polylla_options.smooth_method) == valid_methods.end())
+            throw std::invalid_argument("invalid smoothing method '" + polylla_options.smooth_method + "'");
+        if (polylla_options.use_regions && regions_or_null == nullptr)
+            throw std::invalid_argument("use_regions requires the regions array");
+
+        mesh = new polylla_mesh();
+        Triangulation *triangulation = new Triangulation(xy, nv, tri, nt, neigh_or_null,
+                                                         polylla_options.use_regions ? regions_or_null : nullptr);
+        mesh->polylla = new Polylla(triangulation, polylla_options);
+        mesh->polygons = mesh->polylla->get_polygon_mesh();
+
+        const CoordinatesView &coordinates = mesh->polygons.coordinates;
+        mesh->xy.resize(2 * static_cast<std::size_t>(coordinates.n_vertices));
+        for (int i = 0; i < coordinates.n_vertices; i++) {
+            mesh->xy[2*i] = coordinates.X(i);
+            mesh->xy[2*i+1] = coordinates.Y(i);
+        }
+        return mesh;
+    } catch (const std::exception &e) {
+        last_error = e.what();
+    } catch (...) {
+        last_error = "unknown error";
+    }
+    delete mesh;
+    return nullptr;
+}
+
+int polylla_num_polygons(const polylla_mesh *mesh) {
+    return mesh->polygons.n_polygons();
+}
+
+int polylla_num_vertices(const polylla_mesh *mesh) {
+    return mesh->polygons.coordinates.n_vertices;
+}
+
+const int64_t *polylla_polygon_offsets(const polylla_mesh *mesh) {
+    return reinterpret_cast<const int64_t*>(mesh->polygons.polygon_offsets.data());
+}
+
+const int *polylla_polygon_vertices(const polylla_mesh *mesh) {
+    return mesh->polygons.polygon_vertices.data();
+}
+
+const int *polylla_polygon_regions(const polylla_mesh *mesh) {
+    return mesh->polygons.polygon_region.empty() ? nullptr : mesh->polygons.polygon_region.data();
+}
+
+const double *polylla_vertex_coordinates(const polylla_mesh *mesh) {
+    return mesh->xy.data();
+}
+
+const char *polylla_last_error(void) {
+    return last_error.c_str();
+}
+
+void polylla_destroy(polylla_mesh *mesh) {
+    delete mesh;
+}
+
+}
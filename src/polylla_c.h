@@ -0,0 +1,67 @@
+/* C interface of Polylla, built as the libpolylla shared library.
+   The triangulation is given as arrays owned by the caller and the polygon mesh is
+   returned as CSR arrays owned by the polylla_mesh handle.
+   The CSR arrays are moved into the handle without copying. The coordinates are copied twice: xy into
+   the vertices of the triangulation, which smoothing moves, and the output vertices into a packed array.
+
+Basic operations
+    polylla_default_options(options): fill options with the default values
+    polylla_create(xy, nv, tri, nt, neigh_or_null, regions_or_null, options): generate the polygon mesh, NULL on error,
+        the progress messages of Polylla are discarded, std::cout of a C++ host is left untouched
+    polylla_num_polygons(mesh), polylla_num_vertices(mesh): size of the polygon mesh
+    polylla_polygon_offsets(mesh): num_polygons + 1 offsets, polygon i is vertices[offsets[i]] ... vertices[offsets[i+1] - 1]
+    polylla_polygon_vertices(mesh): vertex indices of all the polygons
+    polylla_polygon_regions(mesh): region of each polygon, NULL if regions are not used
+    polylla_vertex_coordinates(mesh): 2*num_vertices coordinates x0 y0 x1 y1 ..., after smoothing
+    polylla_last_error(): message of the last error of polylla_create in the calling thread
+    polylla_destroy(mesh): free the mesh and its arrays
+*/
+
+#ifndef POLYLLA_C_H
+#define POLYLLA_C_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define POLYLLA_API __declspec(dllexport)
+#else
+#define POLYLLA_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct polylla_options {
+    int use_regions;            /* non-zero to keep the region boundaries, requires regions_or_null */
+    const char *smooth_method;  /* NULL or "" for no smoothing, "laplacian", "laplacian-edge-ratio", "distmesh", "laplacian-cg" */
+    int smooth_iterations;      /* default 50 */
+    double target_length;       /* distmesh target edge length, -1 to calculate it */
+    int validate_moves;         /* laplacian-cg: undo moves that generate intersecting edges */
+} polylla_options;
+
+typedef struct polylla_mesh polylla_mesh;
+
+POLYLLA_API void polylla_default_options(polylla_options *options);
+
+/* xy: 2*nv coordinates, tri: 3*nt vertex indices (0-based) of the triangles,
+   neigh_or_null: 3*nt neighbours in .neigh order (-1 on the border), the twins are computed when NULL,
+   regions_or_null: region of each triangle, options: NULL for the default options */
+POLYLLA_API polylla_mesh *polylla_create(const double *xy, int nv, const int *tri, int nt,
+                                         const int *neigh_or_null, const int *regions_or_null,
+                                         const polylla_options *options);
+
+POLYLLA_API int polylla_num_polygons(const polylla_mesh *mesh);
+POLYLLA_API int polylla_num_vertices(const polylla_mesh *mesh);
+POLYLLA_API const int64_t *polylla_polygon_offsets(const polylla_mesh *mesh);
+POLYLLA_API const int *polylla_polygon_vertices(const polylla_mesh *mesh);
+POLYLLA_API const int *polylla_polygon_regions(const polylla_mesh *mesh);
+POLYLLA_API const double *polylla_vertex_coordinates(const polylla_mesh *mesh);
+POLYLLA_API const char *polylla_last_error(void);
+POLYLLA_API void polylla_destroy(polylla_mesh *mesh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POLYLLA_C_H */
@@ -0,0 +1,170 @@
+// Wire protocol of Polylla --serve, shared by the server (main.cpp) and tools/polylla_client.cpp.
+// A client connects to the Unix domain socket and sends requests one after the other on the same
+// connection. Each request and each reply is a text line, the arrays of a mesh follow their line
+// as raw little-endian binary.
+//
+// Requests
+//     run <arguments>              an input mode, its files and options as in a --batch manifest line,
+//                                  the outputs are written by the server, paths are relative to its directory
+//     mesh <nv> <nt> <flags> <options>
+//                                  Polylla options, followed by xy (2*nv double), tri (3*nt int32),
+//                                  neigh (3*nt int32) if flags & MESH_NEIGH, regions (nt int32) if flags & MESH_REGIONS
+//     shutdown                     stop the server once the requests in progress are done
+// Replies
+//     ok <time_ms> <output>        run: base name of the written outputs
+//     ok <np> <nv> <nnz> <flags> <time_ms>
+//                                  mesh: followed by offsets (np+1 int64), vertices (nnz int32),
+//                                  xy (2*nv double) and regions (np int32) if flags & MESH_REGIONS
+//     error <message>              the connection can send the next request, except after an invalid mesh
+//                                  header or a mesh larger than --serve-max-triangles, or a failure while
+//                                  its arrays were read: the server then closes the connection
+/*
+Basic operations
+    listen_unix(path), connect_unix(path): listening and connected sockets, throw std::runtime_error
+    write_all(fd, data, bytes), write_line(fd, line): send everything, false if the peer is gone
+    SocketReader reader(fd): reader.read_line(line), reader.read(data, bytes), false at the end of the stream
+*/
+
+#ifndef SERVE_PROTOCOL_HPP
+#define SERVE_PROTOCOL_HPP
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+
+enum mesh_flags { MESH_NEIGH = 1, MESH_REGIONS = 2 };
+
+static constexpr std::size_t SERVE_MAX_LINE = 1 << 16; //longest request or reply line
+
+inline sockaddr_un unix_address(const std::string &path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("invalid socket path '" + path + "'");
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return address;
+}
+
+//A socket left by a previous server is replaced, any other file is kept
+//The socket is bound to a temporary name and renamed once it listens, so the clients that see
+//the path can connect
+inline int listen_unix(const std::string &path, const int backlog = 64) {
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0 && !S_ISSOCK(status.st_mode))
+        throw std::runtime_error(path + " exists and is not a socket");
+    const std::string bound_path = path + "." + std::to_string(getpid());
+    sockaddr_un address = unix_address(bound_path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    unlink(bound_path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, backlog) != 0 ||
+        rename(bound_path.c_str(), path.c_str()) != 0) {
+        const std::string error = std::strerror(errno);
+        close(fd);
+        unlink(bound_path.c_str());
+        throw std::runtime_error("unable to listen on " + path + ": " + error);
+    }
+    return fd;
+}
+
+inline int connect_unix(const std::string &path) {
+    sockaddr_un address = unix_address(path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        const std::string error = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("unable to connect to " + path + ": " + error);
+    }
+    return fd;
+}
+
+//MSG_NOSIGNAL: a closed peer is an error of the write, not a SIGPIPE
+inline bool write_all(const int fd, const void *data, std::size_t bytes) {
+    const char *p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        const ssize_t written = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        bytes -= written;
+    }
+    return true;
+}
+
+inline bool write_line(const int fd, const std::string &line) {
+    const std::string text = line + "\n";
+    return write_all(fd, text.data(), text.size());
+}
+
+//Buffered reads of the lines and of the arrays that follow them
+class SocketReader {
+private:
+    int fd;
+    char buffer[1 << 16];
+    std::size_t begin = 0, end = 0;
+
+    bool fill() {
+        begin = end = 0;
+        ssize_t n;
+        do {
+            n = recv(fd, buffer, sizeof(buffer), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return false;
+        end = n;
+        return true;
+    }
+
+public:
+    explicit SocketReader(const int fd) : fd(fd) {}
+
+    bool buffered() const { return begin < end; }
+
+    //Line without the '\n', false at the end of the stream or if the line is longer than SERVE_MAX_LINE
+    bool read_line(std::string &line) {
+        line.clear();
+        while (true) {
+            if (begin == end && !fill()) return false;
+            const char *newline = static_cast<const char*>(std::memchr(buffer + begin, '\n', end - begin));
+            const std::size_t n = newline ? newline - (buffer + begin) : end - begin;
+            line.append(buffer + begin, n);
+            begin += n;
+            if (line.size() > SERVE_MAX_LINE) return false;
+            if (newline) {
+                begin++;
+                return true;
+            }
+        }
+    }
+
+    //The large arrays are read directly into data once the buffer is empty
+    bool read(void *data, std::size_t bytes) {
+        char *p = static_cast<char*>(data);
+        const std::size_t n = std::min(bytes, end - begin);
+        std::memcpy(p, buffer + begin, n);
+        begin += n;
+        p += n;
+        bytes -= n;
+        while (bytes > 0) {
+            const ssize_t r = recv(fd, p, bytes, MSG_WAITALL);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            p += r;
+            bytes -= r;
+        }
+        return true;
+    }
+};
+
+#endif // SERVE_PROTOCOL_HPP
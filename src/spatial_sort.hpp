@@ -0,0 +1,130 @@
+// Space-filling curve keys to order vertices, triangles and polygons by their position
+// Points are quantized on a 65536 x 65536 grid over a bounding box and the cell is mapped
+// to its position along a Hilbert or a Morton (Z-order) curve, so close keys are close in space.
+/*
+Basic operations
+    hilbert_key(x, y): position of the cell (x, y) along the Hilbert curve, without branches
+    morton_key(x, y): interleaved bits of the cell (x, y)
+    parse_curve(name): curve by name (hilbert, morton), throws std::invalid_argument otherwise
+    CurveGrid grid(min_x, min_y, max_x, max_y, curve): grid.key(x, y) is the key of the point (x, y) of the box
+    sort_by_key(keys): permutation that sorts the keys, ties keep their order (radix sort)
+*/
+
+#ifndef SPATIAL_SORT_HPP
+#define SPATIAL_SORT_HPP
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <cstdint>
+#include <index.hpp>
+
+enum space_filling_curve { CURVE_HILBERT, CURVE_MORTON };
+
+static constexpr int CURVE_BITS = 16; //bits of each coordinate of the grid
+
+//Spread the 16 bits of v to the even bits of the result
+inline std::uint32_t spread_bits(std::uint32_t v) {
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+inline std::uint32_t morton_key(const std::uint32_t x, const std::uint32_t y) {
+    return spread_bits(x) | (spread_bits(y) << 1);
+}
+
+//The rotations of the quadrants at every level are computed for all the levels at once with
+//prefix scans over the bits, in place of a loop over the levels with unpredictable branches
+inline std::uint32_t hilbert_key(const std::uint32_t x, const std::uint32_t y) {
+    std::uint32_t A, B, C, D;
+    {
+        const std::uint32_t a = x ^ y, b = 0xFFFF ^ a, c = 0xFFFF ^ (x | y), d = x & (y ^ 0xFFFF);
+        A = a | (b >> 1);
+        B = (a >> 1) ^ a;
+        C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+        D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+    }
+    for (int shift = 2; shift <= 4; shift *= 2) {
+        const std::uint32_t a = A, b = B, c = C, d = D;
+        A = (a & (a >> shift)) ^ (b & (b >> shift));
+        B = (a & (b >> shift)) ^ (b & ((a ^ b) >> shift));
+        C ^= (a & (c >> shift)) ^ (b & (d >> shift));
+        D ^= (b & (c >> shift)) ^ ((a ^ b) & (d >> shift));
+    }
+    {
+        const std::uint32_t a = A, b = B, c = C, d = D;
+        C ^= (a & (c >> 8)) ^ (b & (d >> 8));
+        D ^= (b & (c >> 8)) ^ ((a ^ b) & (d >> 8));
+    }
+    const std::uint32_t a = C ^ (C >> 1), b = D ^ (D >> 1);
+    const std::uint32_t i0 = x ^ y, i1 = b | (0xFFFF ^ (i0 | a));
+    return (spread_bits(i1) << 1) | spread_bits(i0);
+}
+
+inline space_filling_curve parse_curve(const std::string &name) {
+    if (name == "hilbert") return CURVE_HILBERT;
+    if (name == "morton") return CURVE_MORTON;
+    throw std::invalid_argument("unknown space-filling curve '" + name + "', use hilbert or morton");
+}
+
+//Grid of 2^CURVE_BITS x 2^CURVE_BITS cells over a bounding box
+class CurveGrid {
+private:
+    double min_x, min_y, scale_x, scale_y;
+    space_filling_curve curve;
+
+    static std::uint32_t cell(const double t) {
+        const double max_cell = (1u << CURVE_BITS) - 1;
+        return static_cast<std::uint32_t>(std::min(std::max(t, 0.0), max_cell));
+    }
+
+public:
+    CurveGrid(const double min_x, const double min_y, const double max_x, const double max_y, const space_filling_curve curve)
+        : min_x(min_x), min_y(min_y), curve(curve) {
+        const double cells = (1u << CURVE_BITS) - 1;
+        scale_x = max_x > min_x ? cells / (max_x - min_x) : 0;
+        scale_y = max_y > min_y ? cells / (max_y - min_y) : 0;
+    }
+
+    std::uint32_t key(const double x, const double y) const {
+        const std::uint32_t cx = cell((x - min_x) * scale_x);
+        const std::uint32_t cy = cell((y - min_y) * scale_y);
+        return curve == CURVE_HILBERT ? hilbert_key(cx, cy) : morton_key(cx, cy);
+    }
+};
+
+//Permutation that sorts the keys, order[i] is the index of the i-th smallest key
+//LSD radix sort of the pairs (key, index) by bytes, the pairs are moved by value so each pass
+//reads and writes them sequentially instead of following the indices to the keys
+inline std::vector<index_t> sort_by_key(const std::vector<std::uint32_t> &keys) {
+    const index_t n = static_cast<index_t>(keys.size());
+    if (n == 0) return std::vector<index_t>();
+    std::vector<std::pair<std::uint32_t, index_t>> pairs(n), buffer(n);
+    #pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; i++)
+        pairs[i] = {keys[i], i};
+    for (int shift = 0; shift < 32; shift += 8) {
+        std::size_t count[257] = {0};
+        for (index_t i = 0; i < n; i++)
+            count[((pairs[i].first >> shift) & 0xFF) + 1]++;
+        if (count[((pairs[0].first >> shift) & 0xFF) + 1] == static_cast<std::size_t>(n)) continue; //same byte in all the keys
+        for (int b = 0; b < 256; b++)
+            count[b + 1] += count[b];
+        for (index_t i = 0; i < n; i++)
+            buffer[count[(pairs[i].first >> shift) & 0xFF]++] = pairs[i];
+        pairs.swap(buffer);
+    }
+    std::vector<index_t> order(n);
+    #pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; i++)
+        order[i] = pairs[i].second;
+    return order;
+}
+
+#endif // SPATIAL_SORT_HPP
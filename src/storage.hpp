@@ -0,0 +1,377 @@
+// Backing storage of the large arrays of the triangulation (vertices and half-edges) and of Polylla.
+// heap: operator new, the default
+// hugepages: anonymous mmap advised with MADV_HUGEPAGE, the kernel backs it with transparent huge pages
+//     so the random accesses of the traversal need fewer TLB entries
+// file: shared mmap of an unlinked temporary file, the kernel pages the arrays to the disk of the
+//     directory so meshes larger than the RAM fit
+// Arrays smaller than STORAGE_MIN_MAPPED_BYTES always come from the heap. The backing actually used
+// by each array is recorded, a failed madvise leaves a plain anonymous mapping.
+// The larger arrays are first touched by the OpenMP threads with the static partition of the loops
+// over them, so on NUMA systems each part of the array is placed on the node of the thread that
+// processes it instead of on the node of the thread that allocated it (see numa.hpp).
+// A Workspace keeps the memory of the arrays when they are freed and hands it out again, so a loop
+// over many meshes reuses the same blocks instead of allocating and page faulting for each mesh.
+/*
+Basic operations
+    ArrayStorage::instance(): global storage
+    parse_storage(name): storage_mode by name (heap, hugepages, file), throws std::invalid_argument otherwise
+    set_mode(mode, directory): backing of the next arrays, directory is used by the file mode
+    mode(), mode_name(mode): configured mode
+    peak_bytes(backing): largest number of bytes held at once in the backing, backings are the modes plus STORAGE_ANONYMOUS
+    anon_huge_page_bytes(): AnonHugePages of the process in bytes, -1 if unavailable
+    Workspace workspace: pool of blocks, the blocks not in use are freed by release() and by the destructor
+    blocks(), reused_blocks(), bytes(): blocks held by a workspace, times a block was reused and bytes held
+    WorkspaceScope scope(workspace): the arrays allocated by the calling thread during the scope use the workspace
+    StorageAllocator<T>: allocator that takes the memory from the global storage
+    storage_vector<T>: std::vector<T, StorageAllocator<T>>
+*/
+
+#ifndef STORAGE_HPP
+#define STORAGE_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define POLYLLA_HAS_MMAP 1
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum storage_mode {
+    STORAGE_HEAP,
+    STORAGE_HUGEPAGES,
+    STORAGE_FILE,
+    STORAGE_ANONYMOUS, //backing of the hugepages mode when the kernel rejects the advice
+    N_STORAGE_BACKINGS
+};
+
+static constexpr std::size_t STORAGE_MIN_MAPPED_BYTES = 64 * 1024;
+
+inline storage_mode parse_storage(const std::string &name) {
+    if (name == "heap") return STORAGE_HEAP;
+    if (name == "hugepages") return STORAGE_HUGEPAGES;
+    if (name == "file") return STORAGE_FILE;
+    throw std::invalid_argument("unknown storage '" + name + "', use heap, hugepages or file");
+}
+
+class Workspace;
+
+class ArrayStorage {
+private:
+    friend class Workspace;
+    storage_mode configured = STORAGE_HEAP;
+    std::string directory = "/tmp";
+    std::mutex mappings_mutex;
+    std::unordered_map<void*, std::pair<std::size_t, storage_mode>> mappings; //bytes and backing of each mapped array
+    std::array<long long, N_STORAGE_BACKINGS> current{};
+    std::array<long long, N_STORAGE_BACKINGS> peak{};
+    struct pooled_block {
+        Workspace *owner; //nullptr when the workspace was destroyed while the block was in use
+        std::size_t capacity;
+    };
+    std::unordered_map<void*, pooled_block> pooled; //blocks of the workspaces
+
+    //Workspace of the calling thread, so concurrent loops over meshes can use a workspace each
+    static Workspace*& active() {
+        static thread_local Workspace *workspace = nullptr;
+        return workspace;
+    }
+
+    //Write a byte of each page in a schedule(static) loop, only when there are several threads
+    static void first_touch(void *p, const std::size_t bytes) {
+#ifdef _OPENMP
+        if (omp_get_max_threads() == 1) return;
+        const long long page = 4096;
+        const long long n_pages = (static_cast<long long>(bytes) + page - 1) / page;
+        char *memory = static_cast<char*>(p);
+        #pragma omp parallel for schedule(static)
+        for (long long i = 0; i < n_pages; i++)
+            memory[i * page] = 0;
+#else
+        (void)p;
+        (void)bytes;
+#endif
+    }
+
+    void account(const storage_mode backing, const long long bytes) {
+        current[backing] += bytes;
+        peak[backing] = std::max(peak[backing], current[backing]);
+    }
+
+#ifdef POLYLLA_HAS_MMAP
+    //Map bytes in the configured mode, nullptr if the mapping fails
+    void* map(const std::size_t bytes, storage_mode &backing) {
+        if (configured == STORAGE_FILE) {
+            std::string path = directory + "/polylla-XXXXXX";
+            std::vector<char> name(path.begin(), path.end());
+            name.push_back('\0');
+            int fd = mkstemp(name.data());
+            if (fd < 0) throw std::runtime_error("can not create a storage file in " + directory);
+            unlink(name.data()); //the file is removed when the mapping is closed
+            void *p = nullptr;
+            if (ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+                p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            backing = STORAGE_FILE;
+            return p == MAP_FAILED ? nullptr : p;
+        }
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        backing = STORAGE_ANONYMOUS;
+#ifdef MADV_HUGEPAGE
+        if (madvise(p, bytes, MADV_HUGEPAGE) == 0) backing = STORAGE_HUGEPAGES;
+#endif
+        return p;
+    }
+#endif
+
+public:
+    void* allocate(std::size_t bytes);
+    void deallocate(void *p, std::size_t bytes);
+
+    Workspace* workspace() const { return active(); }
+    void set_workspace(Workspace *workspace) { active() = workspace; }
+
+    static ArrayStorage& instance() {
+        static ArrayStorage storage;
+        return storage;
+    }
+
+    //Arrays allocated before the change keep their backing
+    void set_mode(const storage_mode mode, const std::string &dir = "") {
+        configured = mode;
+        if (!dir.empty()) directory = dir;
+        else if (const char *tmp = std::getenv("TMPDIR")) directory = tmp;
+    }
+
+    storage_mode mode() const { return configured; }
+
+    static const char* mode_name(const storage_mode mode) {
+        static const char *names[N_STORAGE_BACKINGS] = {"heap", "hugepages", "file", "anonymous"};
+        return names[mode];
+    }
+
+    void* allocate_backing(const std::size_t bytes) {
+#ifdef POLYLLA_HAS_MMAP
+        if (configured != STORAGE_HEAP && bytes >= STORAGE_MIN_MAPPED_BYTES) {
+            storage_mode backing;
+            void *p = map(bytes, backing);
+            if (p == nullptr) throw std::bad_alloc();
+            first_touch(p, bytes);
+            std::lock_guard<std::mutex> lock(mappings_mutex);
+            mappings[p] = {bytes, backing};
+            account(backing, bytes);
+            return p;
+        }
+#endif
+        void *p = ::operator new(bytes);
+        if (bytes >= STORAGE_MIN_MAPPED_BYTES) first_touch(p, bytes);
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        account(STORAGE_HEAP, bytes);
+        return p;
+    }
+
+    void deallocate_backing(void *p, const std::size_t bytes) {
+        std::unique_lock<std::mutex> lock(mappings_mutex);
+        auto it = mappings.find(p);
+        if (it == mappings.end()) {
+            account(STORAGE_HEAP, -static_cast<long long>(bytes));
+            lock.unlock();
+            ::operator delete(p);
+            return;
+        }
+        account(it->second.second, -static_cast<long long>(it->second.first));
+#ifdef POLYLLA_HAS_MMAP
+        munmap(p, it->second.first);
+#endif
+        mappings.erase(it);
+    }
+
+    long long peak_bytes(const storage_mode backing) {
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        return peak[backing];
+    }
+
+    //Anonymous memory of the process backed by transparent huge pages, from /proc/self/smaps_rollup
+    static long long anon_huge_page_bytes() {
+        std::ifstream smaps("/proc/self/smaps_rollup");
+        std::string line;
+        while (std::getline(smaps, line)) {
+            if (line.compare(0, 14, "AnonHugePages:") != 0) continue;
+            std::istringstream fields(line.substr(14));
+            long long kb = -1;
+            fields>>kb;
+            return kb < 0 ? -1 : kb * 1024;
+        }
+        return -1;
+    }
+};
+
+class Workspace {
+private:
+    std::mutex blocks_mutex;
+    std::map<std::size_t, std::vector<void*>> free_blocks; //blocks not in use by capacity
+    long long n_blocks = 0;
+    long long n_reused = 0;
+    long long held_bytes = 0;
+
+public:
+    Workspace() = default;
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    ~Workspace() {
+        release();
+        ArrayStorage &storage = ArrayStorage::instance();
+        std::lock_guard<std::mutex> lock(storage.mappings_mutex);
+        for (auto &block : storage.pooled)
+            if (block.second.owner == this) block.second.owner = nullptr;
+        if (ArrayStorage::active() == this) ArrayStorage::active() = nullptr;
+    }
+
+    //Capacity of the block of a request, a multiple of a quarter of a power of two so a block is
+    //at most 25% larger than the request and requests of similar size share blocks
+    static std::size_t block_capacity(const std::size_t bytes) {
+        std::size_t power = 64;
+        if (bytes <= power) return power;
+        while (2 * power < bytes) power *= 2;
+        const std::size_t step = power / 4;
+        return (bytes + step - 1) / step * step;
+    }
+
+    void* take(const std::size_t bytes) {
+        const std::size_t capacity = block_capacity(bytes);
+        {
+            //smallest free block that fits, up to twice the capacity so a small array does not hold a large block
+            std::lock_guard<std::mutex> lock(blocks_mutex);
+            for (auto it = free_blocks.lower_bound(capacity); it != free_blocks.end() && it->first <= 2 * capacity; ++it) {
+                if (it->second.empty()) continue;
+                void *p = it->second.back();
+                it->second.pop_back();
+                n_reused++;
+                return p;
+            }
+        }
+        ArrayStorage &storage = ArrayStorage::instance();
+        void *p = storage.allocate_backing(capacity);
+        {
+            std::lock_guard<std::mutex> lock(storage.mappings_mutex);
+            storage.pooled[p] = {this, capacity};
+        }
+        std::lock_guard<std::mutex> lock(blocks_mutex);
+        n_blocks++;
+        held_bytes += capacity;
+        return p;
+    }
+
+    void give_back(void *p, const std::size_t capacity) {
+        std::lock_guard<std::mutex> lock(blocks_mutex);
+        free_blocks[capacity].push_back(p);
+    }
+
+    //Free the blocks that are not in use
+    void release() {
+        ArrayStorage &storage = ArrayStorage::instance();
+        std::lock_guard<std::mutex> lock(blocks_mutex);
+        for (auto &size_blocks : free_blocks) {
+            for (void *p : size_blocks.second) {
+                {
+                    std::lock_guard<std::mutex> storage_lock(storage.mappings_mutex);
+                    storage.pooled.erase(p);
+                }
+                storage.deallocate_backing(p, size_blocks.first);
+                n_blocks--;
+                held_bytes -= size_blocks.first;
+            }
+            size_blocks.second.clear();
+        }
+    }
+
+    long long blocks() const { return n_blocks; }
+    long long reused_blocks() const { return n_reused; }
+    long long bytes() const { return held_bytes; }
+};
+
+inline void* ArrayStorage::allocate(const std::size_t bytes) {
+    Workspace *workspace = active();
+    if (workspace != nullptr) return workspace->take(bytes);
+    return allocate_backing(bytes);
+}
+
+inline void ArrayStorage::deallocate(void *p, const std::size_t bytes) {
+    std::unique_lock<std::mutex> lock(mappings_mutex);
+    auto it = pooled.find(p);
+    if (it == pooled.end()) {
+        lock.unlock();
+        deallocate_backing(p, bytes);
+        return;
+    }
+    const pooled_block block = it->second;
+    if (block.owner == nullptr) pooled.erase(it);
+    lock.unlock();
+    if (block.owner != nullptr)
+        block.owner->give_back(p, block.capacity);
+    else
+        deallocate_backing(p, block.capacity);
+}
+
+//The arrays allocated during the scope take their memory from the workspace
+class WorkspaceScope {
+private:
+    Workspace *previous;
+
+public:
+    explicit WorkspaceScope(Workspace &workspace) : previous(ArrayStorage::instance().workspace()) {
+        ArrayStorage::instance().set_workspace(&workspace);
+    }
+
+    ~WorkspaceScope() {
+        ArrayStorage::instance().set_workspace(previous);
+    }
+
+    WorkspaceScope(const WorkspaceScope&) = delete;
+    WorkspaceScope& operator=(const WorkspaceScope&) = delete;
+};
+
+template <typename T>
+struct StorageAllocator {
+    typedef T value_type;
+
+    StorageAllocator() = default;
+    template <typename U>
+    StorageAllocator(const StorageAllocator<U>&) {}
+
+    T* allocate(const std::size_t n) {
+        return static_cast<T*>(ArrayStorage::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, const std::size_t n) {
+        ArrayStorage::instance().deallocate(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const StorageAllocator<T>&, const StorageAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const StorageAllocator<T>&, const StorageAllocator<U>&) { return false; }
+
+template <typename T>
+using storage_vector = std::vector<T, StorageAllocator<T>>;
+
+#endif // STORAGE_HPP
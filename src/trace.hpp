@@ -0,0 +1,105 @@
+// Phase tracing in Chrome trace-event format, the output can be opened in chrome://tracing or Perfetto.
+// Each phase is wrapped in a TraceScope, spans are recorded per thread only while tracing is enabled
+/*
+Basic operations
+    Tracer::instance(): global tracer
+    enable(): start recording spans, the timestamps are relative to this call
+    is_enabled(): true if spans are being recorded
+    write(filename): write the recorded spans as a JSON trace-event file
+    TraceScope scope("name"): record a span from the construction of scope to its destruction
+*/
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+struct trace_event {
+    const char *name;
+    double start_us; //microseconds since the tracer was enabled
+    double duration_us;
+    int thread;
+};
+
+class Tracer {
+private:
+    std::atomic<bool> enabled{false};
+    std::chrono::high_resolution_clock::time_point t_origin;
+    std::mutex events_mutex;
+    std::vector<trace_event> events;
+    std::atomic<int> n_threads{0};
+
+public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void enable() {
+        t_origin = std::chrono::high_resolution_clock::now();
+        enabled = true;
+    }
+
+    bool is_enabled() const {
+        return enabled;
+    }
+
+    double now_us() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - t_origin).count();
+    }
+
+    //Small id of the calling thread, given in order of the first span of each thread
+    int thread_id() {
+        thread_local int id = n_threads++;
+        return id;
+    }
+
+    void record(const char *name, const double start_us, const double end_us) {
+        trace_event event = {name, start_us, end_us - start_us, thread_id()};
+        std::lock_guard<std::mutex> lock(events_mutex);
+        events.push_back(event);
+    }
+
+    void write(const std::string &filename) {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        std::ofstream out(filename);
+        out<<std::fixed<<std::setprecision(3);
+        out<<"{\"traceEvents\": ["<<std::endl;
+        for (std::size_t i = 0; i < events.size(); i++) {
+            const trace_event &event = events[i];
+            out<<"{\"name\": \""<<event.name<<"\", \"cat\": \"polylla\", \"ph\": \"X\", \"pid\": 1, \"tid\": "<<event.thread
+               <<", \"ts\": "<<event.start_us<<", \"dur\": "<<event.duration_us<<"}"<<(i + 1 < events.size() ? "," : "")<<std::endl;
+        }
+        out<<"], \"displayTimeUnit\": \"ms\"}"<<std::endl;
+        out.close();
+    }
+};
+
+//Span of a phase, from the construction to the destruction of the scope
+//name must be a string literal, it is stored without copying
+class TraceScope {
+private:
+    const char *name;
+    double start_us = 0;
+    bool active;
+
+public:
+    explicit TraceScope(const char *name) : name(name), active(Tracer::instance().is_enabled()) {
+        if (active) start_us = Tracer::instance().now_us();
+    }
+
+    ~TraceScope() {
+        if (active) Tracer::instance().record(name, start_us, Tracer::instance().now_us());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#endif // TRACE_HPP
@@ -24,8 +24,22 @@ Others
     get_Triangles(): bitvector of triangles where true if the halfege generate a unique face, false if the face is generated by another halfedge
     get_PointX(int i): return the i-th x coordinate of the triangulation
     get_PointY(int i): return the i-th y coordinate of the triangulation    
+    get_Vertices(): return a pointer to the vertices of the triangulation
     set_PointX(int i): set the i-th x coordinate of the triangulation
     set_PointY(int i): set the i-th y coordinate of the triangulation
+Access policy
+    BasicTriangulation<Access>: checked_access uses std::vector::at() in the accessors, unchecked_access operator[]
+    Triangulation: BasicTriangulation<default_access>, checked only in the builds with POLYLLA_CHECKED_ACCESS
+Reordering
+    reorder(curve): renumber the vertices and triangles along a space-filling curve and rebuild the half-edges
+    original_vertex(v): index in the input of the vertex v, v if the mesh was not reordered
+Pipelined read
+    BasicTriangulation(node, ele, neigh, use_regions, true): read the three files on their own threads while the
+        interior half-edges are built from the blocks of triangles already read, see get_pipelined_read()
+Storage
+    Vertices and HalfEdges are storage_vector, their backing (heap, huge pages or a file) is set with ArrayStorage, see storage.hpp
+Index type
+    index_t: vertices, half-edges and faces, std::int32_t or std::int64_t in the builds with POLYLLA_INDEX64
 
 TODO:
     edge_iterator;
@@ -47,6 +61,19 @@ TODO:
 #include <unordered_map>
 #include <map>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+#include <index.hpp>
+#include <spatial_sort.hpp>
+#include <storage.hpp>
+#include <phase.hpp>
 
 // #include <measure.hpp>
 
@@ -54,219 +81,496 @@ struct vertex{
     double x;
     double y;
     bool is_border = false; // if the vertex is on the boundary
-    int incident_halfedge = -1; // halfedge incident to the vertex, vertex is the origin of the halfedge
+    index_t incident_halfedge = -1; // halfedge incident to the vertex, vertex is the origin of the halfedge
 };
 
 
 
 struct halfEdge {
-    int origin; //tail of edge
+    index_t origin; //tail of edge
     //int target; //head of edge
-    int twin; //opposite halfedge
-    int next; //next halfedge of the same face
-    int prev; //previous halfedge of the same face
+    index_t twin; //opposite halfedge
+    index_t next; //next halfedge of the same face
+    index_t prev; //previous halfedge of the same face
    // int face = -1; //face index incident to the halfedge
     int is_border; //1 if the halfedge is on the boundary, 0 otherwise
 };
 
-// Esta fue la unica función ql funciono, porque las weas nativas de c++ funcionan mal
-//https://stackoverflow.com/a/22395635
-// Returns false if the string contains any non-whitespace characters
-// Returns false if the string contains any non-ASCII characters
-static bool isWhitespace(std::string s){
-    for(int index = 0; index < s.length(); index++)
-        if(!std::isspace(s[index]))
-            return false;
-    return true;
+//Access policies of the vertex and half-edge arrays in the accessors (next, twin, origin, ...)
+//The construction of the half-edges is not affected by the policy
+struct checked_access {
+    template <typename C>
+    static auto at(C &c, const std::size_t i) -> decltype(c.at(i)) { return c.at(i); }
+    static constexpr const char *name = "checked";
+};
+
+struct unchecked_access {
+    template <typename C>
+    static auto at(C &c, const std::size_t i) -> decltype(c[i]) { return c[i]; }
+    static constexpr const char *name = "unchecked";
+};
+
+#ifdef POLYLLA_CHECKED_ACCESS
+typedef checked_access default_access;
+#else
+typedef unchecked_access default_access;
+#endif
+
+//Input file of the readers, the file "-" is the standard input. The sections of a stream
+//(.node, .ele and .neigh) are read one after the other, so each reader stops after its last line
+struct input_stream {
+    std::ifstream file;
+    std::istream *in;
+
+    explicit input_stream(const std::string &name) : in(name == "-" ? &std::cin : &file) {
+        if (name != "-") file.open(name);
+    }
+
+    bool is_open() const { return in == &std::cin || file.is_open(); }
+};
+
+//Next line that is not empty nor a comment, false at the end of the stream
+static bool next_data_line(std::istream &in, std::string &line) {
+    while (std::getline(in, line)) {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first != std::string::npos && line[first] != '#') return true;
+    }
+    return false;
+}
+
+//Vertex indices of the count triangles in [0, nv) and neighbour indices in [-1, nt), neighs can be nullptr
+//The half-edges are built without bounds checks, so the constructors check their input with it
+template <typename I>
+inline void check_triangles(const I *faces, const I *neighs, const index_t count, const index_t nv, const index_t nt) {
+    for (std::size_t i = 0; i < 3*static_cast<std::size_t>(count); i++) {
+        if (faces[i] < 0 || faces[i] >= nv)
+            throw std::runtime_error("triangle vertex index out of range: " + std::to_string(faces[i]));
+        if (neighs != nullptr && (neighs[i] < -1 || neighs[i] >= nt))
+            throw std::runtime_error("neighbour index out of range: " + std::to_string(neighs[i]));
+    }
+}
+
+//Blocks of lines parsed by a reader thread for the thread that consumes them, at most capacity
+//blocks wait in the queue so a fast reader does not hold the whole file
+template <typename T>
+class block_queue {
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<T>> blocks;
+    std::size_t capacity;
+    bool closed = false;
+
+public:
+    explicit block_queue(const std::size_t capacity) : capacity(capacity) {}
+
+    void push(std::vector<T> &&block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return blocks.size() < capacity; });
+        blocks.push_back(std::move(block));
+        changed.notify_all();
+    }
+
+    //No block is pushed after close
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+
+    //false once the queue is closed and empty
+    bool pop(std::vector<T> &block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return closed || !blocks.empty(); });
+        if (blocks.empty()) return false;
+        block = std::move(blocks.front());
+        blocks.pop_front();
+        changed.notify_all();
+        return true;
+    }
+};
+
+//CPU time of the calling thread in ms, the time of a thread that waits for the cpu is not counted
+//Wall time where the thread clock is unavailable
+inline double thread_cpu_ms() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec * 1e-6;
+#else
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static constexpr index_t PIPELINE_BLOCK = 1 << 15; //triangles of a block of the pipelined read
+static constexpr std::size_t PIPELINE_QUEUE = 8; //blocks waiting in each queue
+
+//Times in ms of the pipelined read of a .node, .ele and .neigh, total is 0 if it was not used
+struct pipelined_read_stats {
+    double read_node = 0, read_ele = 0, read_neigh = 0; //CPU time of the parsing of each reader thread
+    double build_interior = 0; //CPU time of the construction of the interior half-edges
+    double total = 0; //wall time from the start of the reads to the last interior half-edge
+
+    //Fraction of the serial time hidden by running the readers and the construction at the same time,
+    //about 0 with a single cpu
+    double overlap() const {
+        const double serial = read_node + read_ele + read_neigh + build_interior;
+        return serial > 0 ? std::max(0.0, 1 - total/serial) : 0;
+    }
+};
+
+//A file or stream that ends before the number of lines of its header is an error, the arrays would be
+//shorter than the counts of the triangulation
+static void check_read_count(const std::string &name, const char *what, const std::size_t expected, const std::size_t read) {
+    if (read != expected)
+        throw std::runtime_error((name == "-" ? std::string("stdin") : name) + ": expected " + std::to_string(expected) +
+                                 " " + what + ", read " + std::to_string(read));
 }
 
-class Triangulation 
+template <typename Access = default_access>
+class BasicTriangulation
 {
 
 private:
 
-    typedef std::array<int,3> _triangle; 
-    typedef std::pair<int,int> _edge;
+    typedef std::array<index_t,3> _triangle; 
+    typedef std::pair<index_t,index_t> _edge;
 
     //Statically data
-    int n_halfedges = 0; //number of halfedges
-    int n_faces = 0; //number of faces
-    int n_vertices = 0; //number of vertices
-    int n_border_edges = 0; //number of border edges
+    index_t n_halfedges = 0; //number of halfedges
+    index_t n_faces = 0; //number of faces
+    index_t n_vertices = 0; //number of vertices
+    index_t n_border_edges = 0; //number of border edges
     double t_triangulation_generation = 0; //time to generate the triangulation
+    double t_read_input = 0; //time to read the input files
+    pipelined_read_stats pipelined_read;
 
 
-    std::vector<vertex> Vertices;
-    std::vector<halfEdge> HalfEdges; //list of edges
+    storage_vector<vertex> Vertices;
+    storage_vector<halfEdge> HalfEdges; //list of edges
     //std::vector<char> triangle_flags; //list of edges that generate a unique triangles, 
-    std::vector<int> triangle_list; //list of edges that generate a unique triangles,
-    std::vector<int> triangle_regions; //list of the region of each triangle
+    std::vector<index_t> triangle_list; //list of edges that generate a unique triangles,
+    storage_vector<int> triangle_regions; //list of the region of each triangle
+    std::vector<index_t> input_vertices; //index in the input of each vertex after reorder(), empty if not reordered
     
 
 
     //Read node file in .node format and nodes in point vector
     void read_nodes_from_file(std::string name){
         std::string line;
-        std::ifstream nodefile(name);
+        input_stream nodefile(name);
+        if (!nodefile.is_open() || !next_data_line(*nodefile.in, line))
+            throw std::runtime_error("Unable to read the node file " + name);
+        std::istringstream(line) >> n_vertices;
+        Vertices.reserve(n_vertices);
+        read_node_lines(*nodefile.in, n_vertices);
+        check_read_count(name, "vertices", n_vertices, Vertices.size());
+    }
+
+    //Read the next n vertices of a .node file, after its first line
+    void read_node_lines(std::istream &in, const index_t n){
+        std::string line;
         double a1, a2, a3, a4;
-        
-        //std::cout<<"Node file"<<std::endl;
-        if (nodefile.is_open())
+        for (index_t i = 0; i < n && next_data_line(in, line); i++)
         {
-            nodefile >> n_vertices;
-            //std::cout<<pnumber<<std::endl;
-            Vertices.reserve(n_vertices);
-            std::getline(nodefile, line); //skip the first line
-            while (std::getline(nodefile, line))
-            {
-                std::istringstream(line) >> a1 >> a2 >> a3 >> a4;
-                vertex ve;
-                ve.x =  a2;
-                ve.y =  a3;
-                ve.is_border = (a4 == 1) ? true : false;
-                Vertices.push_back(ve);
-            }  
+            a4 = 0;
+            std::istringstream(line) >> a1 >> a2 >> a3 >> a4;
+            vertex ve;
+            ve.x =  a2;
+            ve.y =  a3;
+            ve.is_border = (a4 == 1) ? true : false;
+            Vertices.push_back(ve);
         }
-        else 
-            std::cout << "Unable to open node file"; 
-        nodefile.close();
     }
 
-    //Read triangle file in .ele format and stores it in faces vector
-    std::vector<int> read_triangles_from_file(std::string name, bool read_regions = false){
-        std::vector<int> faces;
-        std::string line;
-        std::ifstream elefile(name);
-        //std::cout<<"Node file"<<std::endl;
+    //Read the first line of a .ele file, return true if the regions of the triangles are read
+    bool read_ele_header(const std::string &line, bool read_regions){
+        int nodes_per_triangle = 3, has_attributes = 0;
+        std::istringstream(line) >> n_faces >> nodes_per_triangle >> has_attributes; // Assuming the attribute is region always
         
-        if (elefile.is_open()) {
-            int nodes_per_triangle, has_attributes;
-            elefile >> n_faces >> nodes_per_triangle >> has_attributes; // Assuming the attribute is region always
-            faces.reserve(3*n_faces);
-            
-            // Safety check: if regions are requested but file has no attributes
-            if (read_regions && has_attributes == 0) {
-                std::cout << "Warning: Region processing requested but no attributes found in .ele file" << std::endl;
-                std::cout << "Regions will be ignored for this mesh" << std::endl;
-            }
+        // Safety check: if regions are requested but file has no attributes
+        if (read_regions && has_attributes == 0) {
+            std::cout << "Warning: Region processing requested but no attributes found in .ele file" << std::endl;
+            std::cout << "Regions will be ignored for this mesh" << std::endl;
+        }
+        
+        if (has_attributes > 0 && read_regions) {
+            triangle_regions.reserve(n_faces);
+            return true;
+        }
+        return false;
+    }
+
+    //Read the next n triangles of a .ele file into faces (3*n values), return the number of triangles read
+    index_t read_triangle_lines(std::istream &in, const index_t n, index_t *faces, bool read_regions){
+        std::string line;
+        index_t i = 0;
+        for (; i < n && next_data_line(in, line); i++)
+        {
+            std::istringstream iss(line);
+            index_t triangle_id, v1 = -1, v2 = -1, v3 = -1; //a line that does not parse fails check_triangles
+            iss >> triangle_id >> v1 >> v2 >> v3;
             
-            if (has_attributes > 0 && read_regions) {
-                triangle_regions.reserve(n_faces);
-            }
+            faces[3*i] = v1;
+            faces[3*i+1] = v2;
+            faces[3*i+2] = v3;
             
-            std::getline(elefile, line); //skip the first line
-            while (std::getline(elefile, line))
+            if (read_regions)
             {
-                if (line[0] != '#')
-                {
-                    std::istringstream iss(line);
-                    int triangle_id, v1, v2, v3;
-                    iss >> triangle_id >> v1 >> v2 >> v3;
-                    
-                    faces.push_back(v1);
-                    faces.push_back(v2);
-                    faces.push_back(v3);
-                    
-                    if (has_attributes > 0 && read_regions)
-                    {
-                        int region;
-                        iss >> region;
-                        triangle_regions.push_back(region);
-                    }
-                }
+                int region;
+                iss >> region;
+                triangle_regions.push_back(region);
             }
         }
-        else 
-            std::cout << "Unable to open ele file"; 
-        elefile.close();
+        return i;
+    }
 
+    //Read triangle file in .ele format and stores it in faces vector
+    storage_vector<index_t> read_triangles_from_file(std::string name, bool read_regions = false){
+        storage_vector<index_t> faces;
+        std::string line;
+        input_stream elefile(name);
+        
+        if (!elefile.is_open() || !next_data_line(*elefile.in, line))
+            throw std::runtime_error("Unable to read the ele file " + name);
+        read_regions = read_ele_header(line, read_regions);
+        faces.resize(3*n_faces);
+        check_read_count(name, "triangles", n_faces, read_triangle_lines(*elefile.in, n_faces, faces.data(), read_regions));
         return faces;
     }
 
+    //Read the next n lines of a .neigh file into neighs (3*n values) and count the border edges,
+    //return the number of triangles read
+    index_t read_neigh_lines(std::istream &in, const index_t n, index_t *neighs){
+        std::string line;
+        index_t i = 0;
+        for (; i < n && next_data_line(in, line); i++)
+        {
+            index_t a1, a2 = -2, a3 = -2, a4 = -2; //a line that does not parse fails check_triangles
+            std::istringstream(line) >> a1 >> a2 >> a3 >> a4;
+            
+            neighs[3*i] = a2;
+            neighs[3*i+1] = a3;
+            neighs[3*i+2] = a4;
+
+            // count all number minior than 0 as border edges
+            n_border_edges += (a2 < 0) + (a3 < 0) + (a4 < 0);
+        }
+        return i;
+    }
+
     //Read node file in .node format and nodes in point vector
-    std::vector<int>  read_neigh_from_file(std::string name){
-        std::vector<int> neighs;
+    storage_vector<index_t> read_neigh_from_file(std::string name){
+        storage_vector<index_t> neighs;
         std::string line;
-        std::ifstream neighfile(name);
-        int a1, a2, a3, a4;
+        input_stream neighfile(name);
         
-        //std::cout<<"Node file"<<std::endl;
-        if (neighfile.is_open())
+        if (!neighfile.is_open() || !next_data_line(*neighfile.in, line))
+            throw std::runtime_error("Unable to read the neigh file " + name);
+        index_t n_neigh_faces = 0;
+        std::istringstream(line) >> n_neigh_faces;
+        check_read_count(name, "triangles as in the ele file", n_faces, n_neigh_faces);
+        neighs.resize(3*n_faces);
+        check_read_count(name, "triangles", n_faces, read_neigh_lines(*neighfile.in, n_faces, neighs.data()));
+        return neighs;
+    }
+
+    //Sizes of the arrays read against the headers and indices of the triangles, throw std::runtime_error
+    //n_face_values and n_neigh_values are the sizes of faces and neighs, neighs can be nullptr
+    template <typename I>
+    void check_input(const I *faces, const std::size_t n_face_values, const I *neighs, const std::size_t n_neigh_values){
+        if (Vertices.size() != static_cast<std::size_t>(n_vertices))
+            throw std::runtime_error("the input has " + std::to_string(Vertices.size()) + " vertices, expected " + std::to_string(n_vertices));
+        if (n_face_values != 3*static_cast<std::size_t>(n_faces))
+            throw std::runtime_error("the input has " + std::to_string(n_face_values/3) + " triangles, expected " + std::to_string(n_faces));
+        if (neighs != nullptr && n_neigh_values != n_face_values)
+            throw std::runtime_error("the input has " + std::to_string(n_neigh_values/3) + " triangles in the neighbours, expected " + std::to_string(n_faces));
+        check_triangles(faces, neighs, n_faces, n_vertices, n_faces);
+    }
+
+    //Interior half-edges of the count faces from first, faces and neighs hold only these faces.
+    //The twins of an edge are set by the second of its two faces, so the blocks already built are not needed
+    template <typename I>
+    void construct_interior_halfEdges_from_block(const I *faces, const I *neighs, const index_t first, const index_t count){
+        for(index_t f = 0; f < count; f++){
+            const index_t i = first + f;
+            for(index_t j = 0; j < 3; j++){
+                halfEdge he;
+                const index_t neigh = neighs[3*f + (j+2)%3];
+                const index_t origin = faces[3*f + j];
+                const index_t target = faces[3*f + (j+1)%3];
+                he.origin = origin;
+                he.next = 3*i + (j+1)%3;
+                he.prev = 3*i + (j+2)%3;
+                he.is_border = (neigh == -1);
+                he.twin = -1;
+                if(neigh != -1 && neigh < i){
+                    for(index_t k = 0; k < 3; k++){
+                        if(HalfEdges[3*neigh + k].origin == target && HalfEdges[3*neigh + (k+1)%3].origin == origin){
+                            he.twin = 3*neigh + k;
+                            HalfEdges[3*neigh + k].twin = 3*i + j;
+                            break;
+                        }
+                    }
+                }
+                HalfEdges.push_back(he);
+            }
+        }
+    }
+
+    //Read the .node, .ele and .neigh files on three threads, the .ele and .neigh in blocks of PIPELINE_BLOCK
+    //triangles, while this thread builds the interior half-edges of each block and drops it.
+    //The arrays are reserved here from the headers, the readers only fill them
+    void read_pipelined(const std::string &node_file, const std::string &ele_file, const std::string &neigh_file, const bool use_regions){
+        typedef std::chrono::high_resolution_clock clock;
+        auto ms_since = [](const clock::time_point t) { return std::chrono::duration<double, std::milli>(clock::now() - t).count(); };
+        input_stream nodefile(node_file), elefile(ele_file), neighfile(neigh_file);
+        std::string node_header, ele_header, neigh_header;
+        if (!nodefile.is_open() || !next_data_line(*nodefile.in, node_header) ||
+            !elefile.is_open() || !next_data_line(*elefile.in, ele_header) ||
+            !neighfile.is_open() || !next_data_line(*neighfile.in, neigh_header))
+            throw std::runtime_error("Unable to read " + node_file + ", " + ele_file + " and " + neigh_file);
+        std::istringstream(node_header) >> n_vertices;
+        Vertices.reserve(n_vertices);
+        const bool read_regions = read_ele_header(ele_header, use_regions);
+        index_t n_neigh_faces = 0;
+        std::istringstream(neigh_header) >> n_neigh_faces;
+        check_read_count(neigh_file, "triangles as in the ele file", n_faces, n_neigh_faces);
+        const index_t n = n_faces;
+        //interior half-edges and the exterior ones of a triangulation without holes
+        HalfEdges.reserve(3*n + std::max<index_t>(0, 2*n_vertices - n - 2));
+
+        auto t_start = clock::now();
+        clock::time_point t_node_end, t_ele_end, t_neigh_end;
+        index_t ele_read = 0, neigh_read = 0;
+        block_queue<index_t> ele_blocks(PIPELINE_QUEUE), neigh_blocks(PIPELINE_QUEUE);
+        std::thread node_reader([&]() {
+            TraceScope trace("read_node_file");
+            const double cpu_start = thread_cpu_ms();
+            read_node_lines(*nodefile.in, n_vertices);
+            pipelined_read.read_node = thread_cpu_ms() - cpu_start;
+            t_node_end = clock::now();
+        });
+        std::thread ele_reader([&]() {
+            TraceScope trace("read_ele_file");
+            for (index_t first = 0; first < n; first += PIPELINE_BLOCK) {
+                const double cpu_start = thread_cpu_ms();
+                std::vector<index_t> block(3*std::min(PIPELINE_BLOCK, n - first));
+                block.resize(3*read_triangle_lines(*elefile.in, block.size()/3, block.data(), read_regions));
+                pipelined_read.read_ele += thread_cpu_ms() - cpu_start;
+                ele_read += block.size()/3;
+                if (block.empty()) break;
+                ele_blocks.push(std::move(block));
+            }
+            t_ele_end = clock::now();
+            ele_blocks.close();
+        });
+        std::thread neigh_reader([&]() {
+            TraceScope trace("read_neigh_file");
+            for (index_t first = 0; first < n; first += PIPELINE_BLOCK) {
+                const double cpu_start = thread_cpu_ms();
+                std::vector<index_t> block(3*std::min(PIPELINE_BLOCK, n - first));
+                block.resize(3*read_neigh_lines(*neighfile.in, block.size()/3, block.data()));
+                pipelined_read.read_neigh += thread_cpu_ms() - cpu_start;
+                neigh_read += block.size()/3;
+                if (block.empty()) break;
+                neigh_blocks.push(std::move(block));
+            }
+            t_neigh_end = clock::now();
+            neigh_blocks.close();
+        });
+
+        index_t built = 0;
+        std::string error; //the readers are joined before it is thrown
         {
-            neighfile >> n_faces;
-            //std::cout<<pnumber<<std::endl;
-            neighs.reserve(3*n_faces);
-            std::getline(neighfile, line); //skip the first line
-            while (std::getline(neighfile, line))
-            {
-                if(line[0] == '#'){
-                    std::cout<<line<<std::endl;
+            TraceScope trace("construct_interior_halfedges");
+            std::vector<index_t> faces, neighs;
+            while (ele_blocks.pop(faces) && neigh_blocks.pop(neighs)) {
+                if (!error.empty()) continue;
+                const double cpu_start = thread_cpu_ms();
+                const index_t count = std::min(faces.size(), neighs.size())/3;
+                try {
+                    check_triangles(faces.data(), neighs.data(), count, n_vertices, n);
+                } catch (const std::runtime_error &e) {
+                    error = e.what();
                     continue;
                 }
-                std::istringstream(line) >> a1 >> a2 >> a3 >> a4;
-                
-                neighs.push_back(a2);
-                neighs.push_back(a3);
-                neighs.push_back(a4);
-
-                // count all number minior than 0 as border edges
-                if(a2 < 0){
-                    n_border_edges++;
-                    //std::cout<<"Border edge 0 "<<a1<<" "<<a2<<" "<<a3<<" "<<a4<<std::endl;
-                }
-                if(a3 < 0){
-                    n_border_edges++;
-                    //std::cout<<"Border edge 1 "<<a1<<" "<<a2<<" "<<a3<<" "<<a4<<std::endl;
-                }
-                if(a4 < 0){
-                    n_border_edges++;
-                    //std::cout<<"Border edge 2 "<<a1<<" "<<a2<<" "<<a3<<" "<<a4<<std::endl;
-                }
+                construct_interior_halfEdges_from_block(faces.data(), neighs.data(), built, count);
+                built += count;
+                pipelined_read.build_interior += thread_cpu_ms() - cpu_start;
             }
+            //a truncated file ends one queue first, the other reader may wait on a full queue
+            while (ele_blocks.pop(faces)) {}
+            while (neigh_blocks.pop(neighs)) {}
         }
-        else 
-            std::cout << "Unable to open node file"; 
-        neighfile.close();
-        return neighs;
+        node_reader.join();
+        ele_reader.join();
+        neigh_reader.join();
+        check_read_count(node_file, "vertices", n_vertices, Vertices.size());
+        check_read_count(ele_file, "triangles", n_faces, ele_read);
+        check_read_count(neigh_file, "triangles", n_faces, neigh_read);
+        if (!error.empty())
+            throw std::runtime_error(error);
+
+        //the last half-edge of each vertex, as in the construction from the whole arrays
+        const double cpu_incident = thread_cpu_ms();
+        for (std::size_t e = 0; e < HalfEdges.size(); e++)
+            Vertices[HalfEdges[e].origin].incident_halfedge = e;
+        pipelined_read.build_interior += thread_cpu_ms() - cpu_incident;
+        pipelined_read.total = ms_since(t_start);
+        t_read_input = std::chrono::duration<double, std::milli>(std::max({t_node_end, t_ele_end, t_neigh_end}) - t_start).count();
+        t_triangulation_generation = std::max(0.0, pipelined_read.total - t_read_input);
+    }
+
+    //Slot of the directed edge (origin, target) in an open addressing table of the given power of two size
+    static std::size_t edge_slot(const index_t origin, const index_t target, const std::size_t size) {
+        std::uint64_t h = static_cast<std::uint64_t>(origin) * 0x9e3779b97f4a7c15ULL + static_cast<std::uint64_t>(target);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h) & (size - 1);
     }
 
- void construct_interior_halfEdges_from_faces(std::vector<int> &faces){
-        //std::cout << "0. aca "<< std::endl;	
-        auto hash_for_pair = [n = 3*this->n_faces](const std::pair<int, int>& p) {
-            return std::hash<int>{}(p.first)*n + std::hash<int>{}(p.second);
-        };
-        std::unordered_map<_edge, int, decltype(hash_for_pair)> map_edges(3*this->n_faces, hash_for_pair); //set of edges to calculate the boundary and twin edges
-        //std::cout << "1. aca "<< std::endl;
+    //The twins are found in an open addressing table of the half-edges by (origin, target), with linear
+    //probing in a single array, so the construction does not allocate a node per edge
+    template <typename I>
+    void construct_interior_halfEdges_from_faces(const I *faces){
+        std::size_t table_size = 1;
+        while (table_size < 6*static_cast<std::size_t>(this->n_faces)) table_size *= 2;
+        storage_vector<index_t> edge_table(table_size, -1); //half-edge of each slot, -1 if empty
+        auto target_of = [faces](const std::size_t e) { return faces[e - e%3 + (e%3 + 1)%3]; };
         for(std::size_t i = 0; i < n_faces; i++){
             for(std::size_t j = 0; j < 3; j++){
                 halfEdge he;
-                int v_origin = faces.at(3*i+j);
-                int v_target = faces.at(3*i+(j+1)%3);
+                index_t v_origin = faces[3*i+j];
+                index_t v_target = faces[3*i+(j+1)%3];
                 he.origin = v_origin;
                 he.next = i*3+(j+1)%3;
                 he.prev = i*3+(j+2)%3;
                 he.is_border = false;
                 he.twin = -1;
                 Vertices.at(v_origin).incident_halfedge = i*3+j;
-                map_edges[std::make_pair(v_origin, v_target)] = i*3+j;
+                //a repeated directed edge keeps the last half-edge
+                std::size_t slot = edge_slot(v_origin, v_target, table_size);
+                while (edge_table[slot] != -1 && (faces[edge_table[slot]] != v_origin || target_of(edge_table[slot]) != v_target))
+                    slot = (slot + 1) & (table_size - 1);
+                edge_table[slot] = i*3+j;
                 HalfEdges.push_back(he);
             }
-            //std::cout << i << std::endl;
         }
-        //std::cout << "2. aca "<< std::endl;	
-        
-        //Calculate twin halfedge and boundary halfedges from set_edges
-        std::unordered_map<_edge,int, decltype(hash_for_pair)>::iterator it;
+
+        //Calculate twin halfedge and boundary halfedges from the table
         for(std::size_t i = 0; i < HalfEdges.size(); i++){
             //if halfedge has no twin
             if(HalfEdges.at(i).twin == -1){
-                int tgt = origin(next(i));
-                int org = origin(i);
-                _edge twin = std::make_pair(tgt, org);
-                it=map_edges.find(twin);
+                index_t tgt = origin(next(i));
+                index_t org = origin(i);
+                std::size_t slot = edge_slot(tgt, org, table_size);
+                while (edge_table[slot] != -1 && (faces[edge_table[slot]] != tgt || target_of(edge_table[slot]) != org))
+                    slot = (slot + 1) & (table_size - 1);
                 //if twin is found
-                if(it!=map_edges.end()){
-                    int index_twin = it->second;
+                if(edge_table[slot] != -1){
+                    index_t index_twin = edge_table[slot];
                     HalfEdges.at(i).twin = index_twin;
                     HalfEdges.at(index_twin).twin = i;
                 }else{ //if twin is not found and halfedge is on the boundary
@@ -276,16 +580,16 @@ private:
                 }
             }
         }
-        //std::cout << "3. aca "<< std::endl;	
     }
     //Generate interior halfedges using faces and neigh vectors
     //also associate each vertex with an incident halfedge
-    void construct_interior_halfEdges_from_faces_and_neighs(std::vector<int> &faces, std::vector<int> &neighs){
-        int neigh, origin, target;
+    template <typename I>
+    void construct_interior_halfEdges_from_faces_and_neighs(const I *faces, const I *neighs){
+        index_t neigh, origin, target;
         for(std::size_t i = 0; i < n_faces; i++){
             for(std::size_t j = 0; j < 3; j++){
                 halfEdge he;
-                neigh = neighs.at(3*i + ((j+2)%3));
+                neigh = neighs[3*i + ((j+2)%3)];
                 origin = faces[3*i+j];
                 target = faces[3*i+((j+1)%3)];
 
@@ -297,7 +601,7 @@ private:
                 he.is_border = (neigh == -1);
                 if(neigh != -1){
                     for (std::size_t j = 0; j < 3; j++){
-                        if(faces.at(3*neigh + j) == target && faces.at(3*neigh + (j + 1)%3) == origin){
+                        if(faces[3*neigh + j] == target && faces[3*neigh + (j + 1)%3] == origin){
                             he.twin = 3*neigh + j;
                             break;
                         }
@@ -314,6 +618,7 @@ private:
     //Generate exterior halfedges
     //This takes  n + k time where n is the number of vertices and k is the number of border edges
     void construct_exterior_halfEdges(){
+        PhaseScope phase("construct_exterior_halfedges");
 
         //search interior edges labed as border, generates exterior edges
         //with the origin and target inverted and add at the of HalfEdges vector
@@ -334,7 +639,7 @@ private:
             }    
         }
         //traverse the exterior edges and search their next prev halfedge
-        int nxtCCW, prvCCW;
+        index_t nxtCCW, prvCCW;
         for(std::size_t i = n_halfedges; i < HalfEdges.size(); i++){
             if(HalfEdges.at(i).is_border){
                 nxtCCW = CCW_edge_to_vertex(HalfEdges.at(i).twin);
@@ -353,109 +658,112 @@ private:
 
 
     //Read the mesh from a file in OFF format
-    std::vector<int> read_OFFfile(std::string name){
+    storage_vector<index_t> read_OFFfile(std::string name){
         //Read the OFF file
-        std::vector<int> faces;
-		std::string line;
-		std::ifstream offfile(name);
-		double a1, a2, a3;
-		std::string tmp;
-		if (offfile.is_open())
-		{
+        storage_vector<index_t> faces;
+        std::string line;
+        input_stream offfile(name);
+        double a1, a2, a3;
+        if (offfile.is_open())
+        {
             //Check first line is a OFF file
-			while (std::getline(offfile, line)){ //add check boundary vertices flag
-                std::istringstream(line) >> tmp;
-                //std::cout<<"tmp: "<<tmp<<std::endl;
-				if (tmp[0] != '#' && !isWhitespace(line))
-				{
-					if(tmp[0] == 'O' && tmp[1] == 'F' && tmp[2] == 'F') //Check if the format is OFF
-                        break;
-                    else{
-                        std::cout<<"The file is not an OFF file"<<std::endl;
-                        exit(0);
-                    }
-				}
-			}
+            if (!next_data_line(*offfile.in, line) || line.compare(line.find_first_not_of(" \t"), 3, "OFF") != 0)
+                throw std::runtime_error("The file " + name + " is not an OFF file");
 
             //Read the number of vertices and faces
-            while (std::getline(offfile, line)){ //add check boundary vertices flag
-                std::istringstream(line) >> tmp;
-               // std::cout<<"tmp: "<<tmp<<std::endl;
-				if (tmp[0] != '#' && !isWhitespace(line))
-                { 
-                            std::istringstream(line) >> this->n_vertices >> this->n_faces;
-                            this->Vertices.reserve(this->n_vertices);
-                            faces.reserve(3*this->n_faces);
-                            break;
-                            
-                }
-			}
+            if (!next_data_line(*offfile.in, line))
+                throw std::runtime_error("The file " + name + " has no number of vertices and faces");
+            std::istringstream(line) >> this->n_vertices >> this->n_faces;
+            this->Vertices.reserve(this->n_vertices);
+            faces.reserve(3*this->n_faces);
 
             //Read vertices
-            int index = 0;
-			while (index < n_vertices && std::getline(offfile, line) )
-			{
-				std::istringstream(line) >> tmp;
-                // std::cout<<"tmp: "<<tmp<<std::endl;
-				if (tmp[0] != '#' && !isWhitespace(line))
-				{
-					std::istringstream(line) >> a1 >> a2 >> a3;
-					vertex ve;
-                    ve.x =  a1;
-                    ve.y =  a2;
-                    this->Vertices.push_back(ve);
-                    index++;
-				}
-			}
+            for (index_t index = 0; index < n_vertices && next_data_line(*offfile.in, line); index++)
+            {
+                std::istringstream(line) >> a1 >> a2 >> a3;
+                vertex ve;
+                ve.x =  a1;
+                ve.y =  a2;
+                this->Vertices.push_back(ve);
+            }
+            check_read_count(name, "vertices", n_vertices, Vertices.size());
+
             //Read faces
-            
-            int lenght, t1, t2, t3;
-            index = 0;
-			while (index < n_faces && std::getline(offfile, line) )
-			{
-				std::istringstream(line) >> tmp;
-                // std::cout<<"tmp: "<<tmp<<std::endl;
-				if (tmp[0] != '#' && !isWhitespace(line))
-				{
-                    std::istringstream(line) >> lenght >> t1 >> t2 >> t3;
-                    faces.push_back(t1);
-                    faces.push_back(t2);
-                    faces.push_back(t3);
-          //          std::cout<<"face "<<index<<": "<<t1<<" "<<t2<<" "<<t3<<std::endl;
-                    index++;
-				}
-			}
-
-		}
-		else 
-				std::cout << "Unable to open node file"; 
-		offfile.close();
+            for (index_t index = 0; index < n_faces && next_data_line(*offfile.in, line); index++)
+            {
+                index_t lenght, t1 = -1, t2 = -1, t3 = -1; //a line that does not parse fails check_triangles
+                std::istringstream(line) >> lenght >> t1 >> t2 >> t3;
+                faces.push_back(t1);
+                faces.push_back(t2);
+                faces.push_back(t3);
+            }
+            check_read_count(name, "triangles", n_faces, faces.size()/3);
+        }
+        else
+            throw std::runtime_error("Unable to open the OFF file " + name);
         return faces;
     }
 
 
 public:
 
+    //The objects are placed by ArrayStorage like their arrays, so inside a WorkspaceScope they reuse its blocks
+    static void* operator new(const std::size_t bytes) {
+        return ArrayStorage::instance().allocate(bytes);
+    }
+
+    static void operator delete(void *p, const std::size_t bytes) {
+        ArrayStorage::instance().deallocate(p, bytes);
+    }
+
     //default constructor
-    Triangulation() {}
+    BasicTriangulation() {}
 
     //Constructor from file
-    Triangulation(std::string node_file, std::string ele_file, std::string neigh_file, bool use_regions = false) {
-        std::vector<int> faces;
-        std::vector<int> neighs;
-        std::cout<<"Reading node file"<<std::endl;
-        read_nodes_from_file(node_file);
+    //pipelined: read the three files concurrently with the construction of the half-edges, the files
+    //are read one after the other if one of them is the standard input
+    BasicTriangulation(std::string node_file, std::string ele_file, std::string neigh_file, bool use_regions = false, bool pipelined = false) {
+        if (pipelined && node_file != "-" && ele_file != "-" && neigh_file != "-") {
+            {
+                PhaseScope phase("read_pipelined");
+                std::cout<<"Reading node, ele and neigh files in a pipeline"<<std::endl;
+                read_pipelined(node_file, ele_file, neigh_file, use_regions);
+            }
+            auto t_start = std::chrono::high_resolution_clock::now();
+            construct_exterior_halfEdges();
+            t_triangulation_generation += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-t_start).count();
+            return;
+        }
+        storage_vector<index_t> faces;
+        storage_vector<index_t> neighs;
+        auto t_start_read = std::chrono::high_resolution_clock::now();
+        {
+            PhaseScope phase("read_node_file");
+            std::cout<<"Reading node file"<<std::endl;
+            read_nodes_from_file(node_file);
+        }
         //fusionar estos dos métodos
-        std::cout<<"Reading ele file"<<std::endl;
-        faces = read_triangles_from_file(ele_file, use_regions);
-        std::cout<<"Reading neigh file"<<std::endl;
-        neighs = read_neigh_from_file(neigh_file);
+        {
+            PhaseScope phase("read_ele_file");
+            std::cout<<"Reading ele file"<<std::endl;
+            faces = read_triangles_from_file(ele_file, use_regions);
+        }
+        {
+            PhaseScope phase("read_neigh_file");
+            std::cout<<"Reading neigh file"<<std::endl;
+            neighs = read_neigh_from_file(neigh_file);
+        }
+        t_read_input = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-t_start_read).count();
 
         //calculation of the time to build the data structure
         auto t_start = std::chrono::high_resolution_clock::now();
+        check_input(faces.data(), faces.size(), neighs.data(), neighs.size());
         HalfEdges.reserve(3*n_vertices - 3 - n_border_edges);
         //std::cout<<"Constructing interior halfedges"<<std::endl;
-        construct_interior_halfEdges_from_faces_and_neighs(faces, neighs);
+        {
+            PhaseScope phase("construct_interior_halfedges");
+            construct_interior_halfEdges_from_faces_and_neighs(faces.data(), neighs.data());
+        }
         //std::cout<<"Constructing exterior halfedges"<<std::endl;
         construct_exterior_halfEdges();
 
@@ -464,15 +772,25 @@ public:
         t_triangulation_generation = std::chrono::duration<double, std::milli>(t_end-t_start).count();
     }
     
-    Triangulation(std::string OFF_file, bool use_regions = false){
+    BasicTriangulation(std::string OFF_file, bool use_regions = false){
         std::cout<<"Reading OFF file "<<OFF_file<<std::endl;
-        std::vector<int> faces = read_OFFfile(OFF_file);
+        auto t_start_read = std::chrono::high_resolution_clock::now();
+        storage_vector<index_t> faces;
+        {
+            PhaseScope phase("read_off_file");
+            faces = read_OFFfile(OFF_file);
+        }
+        t_read_input = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-t_start_read).count();
 
         std::cout<<"Constructing interior halfedges"<<std::endl;
         auto t_start = std::chrono::high_resolution_clock::now();
+        check_input(faces.data(), faces.size(), static_cast<const index_t*>(nullptr), 0);
         HalfEdges.reserve(3*n_vertices);
         //std::cout<<"Constructing interior halfedges"<<std::endl;
-        construct_interior_halfEdges_from_faces(faces);
+        {
+            PhaseScope phase("construct_interior_halfedges");
+            construct_interior_halfEdges_from_faces(faces.data());
+        }
         //std::cout<<"Constructing exterior halfedges"<<std::endl;
         construct_exterior_halfEdges();
 
@@ -481,18 +799,30 @@ public:
     }
 
     //Constructor from node and ele files only (without neigh)
-    Triangulation(std::string node_file, std::string ele_file, bool use_regions = false) {
-        std::vector<int> faces;
-        std::cout<<"Reading node file"<<std::endl;
-        read_nodes_from_file(node_file);
-        std::cout<<"Reading ele file"<<std::endl;
-        faces = read_triangles_from_file(ele_file, use_regions);
+    BasicTriangulation(std::string node_file, std::string ele_file, bool use_regions = false) {
+        storage_vector<index_t> faces;
+        auto t_start_read = std::chrono::high_resolution_clock::now();
+        {
+            PhaseScope phase("read_node_file");
+            std::cout<<"Reading node file"<<std::endl;
+            read_nodes_from_file(node_file);
+        }
+        {
+            PhaseScope phase("read_ele_file");
+            std::cout<<"Reading ele file"<<std::endl;
+            faces = read_triangles_from_file(ele_file, use_regions);
+        }
+        t_read_input = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-t_start_read).count();
 
         //calculation of the time to build the data structure
         auto t_start = std::chrono::high_resolution_clock::now();
+        check_input(faces.data(), faces.size(), static_cast<const index_t*>(nullptr), 0);
         HalfEdges.reserve(3*n_vertices);
         //std::cout<<"Constructing interior halfedges"<<std::endl;
-        construct_interior_halfEdges_from_faces(faces);
+        {
+            PhaseScope phase("construct_interior_halfedges");
+            construct_interior_halfEdges_from_faces(faces.data());
+        }
         //std::cout<<"Constructing exterior halfedges"<<std::endl;
         construct_exterior_halfEdges();
 
@@ -500,30 +830,73 @@ public:
         t_triangulation_generation = std::chrono::duration<double, std::milli>(t_end-t_start).count();
     }
 
+    //Constructor from arrays, the half-edges are built directly from the caller buffers
+    //xy: 2*nv coordinates x0 y0 x1 y1 ..., tri: 3*nt vertex indices (0-based) of the triangles
+    //neighs: 3*nt neighbours in .neigh order, -1 on the border, or nullptr to compute the twins by hashing the edges
+    //tri and neighs can be int or index_t arrays
+    //regions: region of each triangle or nullptr
+    template <typename I>
+    BasicTriangulation(const double *xy, index_t nv, const I *tri, index_t nt, const I *neighs = nullptr, const int *regions = nullptr) {
+        n_vertices = nv;
+        n_faces = nt;
+        Vertices.resize(n_vertices);
+        for (index_t i = 0; i < n_vertices; i++) {
+            Vertices[i].x = xy[2*i];
+            Vertices[i].y = xy[2*i+1];
+        }
+        if (regions != nullptr)
+            triangle_regions.assign(regions, regions + n_faces);
+
+        auto t_start = std::chrono::high_resolution_clock::now();
+        check_input(tri, 3*static_cast<std::size_t>(n_faces), neighs, 3*static_cast<std::size_t>(n_faces));
+        HalfEdges.reserve(3*n_vertices);
+        if (neighs != nullptr) {
+            PhaseScope phase("construct_interior_halfedges");
+            construct_interior_halfEdges_from_faces_and_neighs(tri, neighs);
+            //the border flag of the vertices is read from the .node markers in the file constructor
+            for (std::size_t e = 0; e < HalfEdges.size(); e++) {
+                if (HalfEdges[e].is_border) {
+                    Vertices[origin(e)].is_border = true;
+                    Vertices[origin(next(e))].is_border = true;
+                }
+            }
+        } else {
+            PhaseScope phase("construct_interior_halfedges");
+            construct_interior_halfEdges_from_faces(tri);
+        }
+        construct_exterior_halfEdges();
+        auto t_end = std::chrono::high_resolution_clock::now();
+        t_triangulation_generation = std::chrono::duration<double, std::milli>(t_end-t_start).count();
+    }
+
     // Copy constructor
-    Triangulation(const Triangulation &t) {
+    BasicTriangulation(const BasicTriangulation &t) {
+        PhaseScope phase("copy_triangulation");
         this->n_vertices = t.n_vertices;
         this->n_faces = t.n_faces;
         this->n_halfedges = t.n_halfedges;
         this->Vertices = t.Vertices;
         this->HalfEdges = t.HalfEdges;
         this->triangle_regions = t.triangle_regions;
+        this->input_vertices = t.input_vertices;
         this->t_triangulation_generation = t.t_triangulation_generation;
+        this->t_read_input = t.t_read_input;
+        this->pipelined_read = t.pipelined_read;
     }
 
-    Triangulation(int size){
-        int n = size;
-        int sqrt_n = (int)sqrt(size);
+    BasicTriangulation(index_t size){
+        index_t n = size;
+        index_t sqrt_n = (index_t)sqrt(size);
 
         n_vertices = size;
-        std::vector<int> faces;
+        storage_vector<index_t> faces;
 
         this->Vertices.reserve(this->n_vertices);
         faces.reserve(2*(n-sqrt_n));
 
         std::cout<<"Generating points  "<<std::endl;
-        for (int i = 0; i < sqrt_n; i++)
-            for (int j = 0; j < sqrt_n; j++)
+        for (index_t i = 0; i < sqrt_n; i++)
+            for (index_t j = 0; j < sqrt_n; j++)
             {
                 vertex ve;
                 ve.x =  (float)i;
@@ -532,7 +905,7 @@ public:
             }
         
         std::cout<<"Generating triangles "<<std::endl;
-        for (int i = 0; i < n-sqrt_n; i++)
+        for (index_t i = 0; i < n-sqrt_n; i++)
         {
             if (i % sqrt_n != sqrt_n-1){
                 faces.push_back(i);
@@ -552,7 +925,7 @@ public:
         auto t_start = std::chrono::high_resolution_clock::now();      
         HalfEdges.reserve(3*n_vertices);
         std::cout<<"Constructing interior halfedges"<<std::endl;
-        construct_interior_halfEdges_from_faces(faces);
+        construct_interior_halfEdges_from_faces(faces.data());
         std::cout<<"Constructing exterior halfedges"<<std::endl;
         construct_exterior_halfEdges();
 
@@ -563,7 +936,7 @@ public:
 
 
     // destructor
-    ~Triangulation() {
+    ~BasicTriangulation() {
         Vertices.clear();
         HalfEdges.clear();
     }
@@ -572,6 +945,95 @@ public:
         return t_triangulation_generation;
     }
 
+    double get_read_input_time() {
+        return t_read_input;
+    }
+
+    const pipelined_read_stats& get_pipelined_read() const {
+        return pipelined_read;
+    }
+
+    //Renumber the vertices by the curve key of their position and the triangles by the key of their
+    //centroid, then rebuild the half-edges in the new order, so the traversals of the phases
+    //visit nearby triangles and vertices at nearby addresses
+    void reorder(const space_filling_curve curve) {
+        PhaseScope phase("reorder");
+        if (n_vertices == 0 || n_faces == 0) return;
+        double min_x = Vertices[0].x, max_x = min_x, min_y = Vertices[0].y, max_y = min_y;
+        for (const vertex &v : Vertices) {
+            min_x = std::min(min_x, v.x);
+            max_x = std::max(max_x, v.x);
+            min_y = std::min(min_y, v.y);
+            max_y = std::max(max_y, v.y);
+        }
+        const CurveGrid grid(min_x, min_y, max_x, max_y, curve);
+
+        //new_vertex[v] is the new index of the vertex v, old_vertex[i] the old index of the new vertex i
+        std::vector<std::uint32_t> keys(n_vertices);
+        #pragma omp parallel for schedule(static)
+        for (index_t v = 0; v < n_vertices; v++)
+            keys[v] = grid.key(Vertices[v].x, Vertices[v].y);
+        const std::vector<index_t> old_vertex = sort_by_key(keys);
+        std::vector<index_t> new_vertex(n_vertices);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n_vertices; i++)
+            new_vertex[old_vertex[i]] = i;
+
+        keys.resize(n_faces);
+        #pragma omp parallel for schedule(static)
+        for (index_t f = 0; f < n_faces; f++) {
+            const vertex &a = Vertices[origin(3*f)], &b = Vertices[origin(3*f+1)], &c = Vertices[origin(3*f+2)];
+            keys[f] = grid.key((a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3);
+        }
+        const std::vector<index_t> old_face = sort_by_key(keys);
+        std::vector<index_t> new_face(n_faces);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n_faces; i++)
+            new_face[old_face[i]] = i;
+
+        //triangles and neighbours in .ele/.neigh layout, the neighbour k is opposite to the vertex k
+        storage_vector<index_t> faces(3*static_cast<std::size_t>(n_faces)), neighs(3*static_cast<std::size_t>(n_faces));
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n_faces; i++) {
+            const index_t f = old_face[i];
+            for (index_t j = 0; j < 3; j++) {
+                const index_t e = 3*f + j;
+                faces[3*i + j] = new_vertex[origin(e)];
+                neighs[3*i + (j+2)%3] = is_border_face(twin(e)) ? -1 : new_face[index_face(twin(e))];
+            }
+        }
+
+        storage_vector<vertex> vertices(n_vertices);
+        #pragma omp parallel for schedule(static)
+        for (index_t i = 0; i < n_vertices; i++) {
+            vertices[i] = Vertices[old_vertex[i]];
+            vertices[i].incident_halfedge = -1;
+        }
+        Vertices.swap(vertices);
+        if (!triangle_regions.empty()) {
+            storage_vector<int> regions(n_faces);
+            for (index_t i = 0; i < n_faces; i++)
+                regions[i] = triangle_regions[old_face[i]];
+            triangle_regions.swap(regions);
+        }
+        std::vector<index_t> input(n_vertices);
+        for (index_t i = 0; i < n_vertices; i++)
+            input[i] = input_vertices.empty() ? old_vertex[i] : input_vertices[old_vertex[i]];
+        input_vertices.swap(input);
+
+        HalfEdges.clear();
+        construct_interior_halfEdges_from_faces_and_neighs(faces.data(), neighs.data());
+        construct_exterior_halfEdges();
+    }
+
+    bool is_reordered() const {
+        return !input_vertices.empty();
+    }
+
+    index_t original_vertex(const index_t v) const {
+        return input_vertices.empty() ? v : input_vertices[v];
+    }
+
     long long get_size_vertex_struct() {
         return sizeof(decltype(Vertices.back())) * Vertices.capacity();
     }
@@ -581,11 +1043,11 @@ public:
     }
 
     // Calculates the distante of edge e
-    double distance(int e){
-        double x1 = Vertices.at(origin(e)).x;
-        double y1 = Vertices.at(origin(e)).y;
-        double x2 = Vertices.at(target(e)).x;
-        double y2 = Vertices.at(target(e)).y;
+    double distance(index_t e){
+        double x1 = Access::at(Vertices, origin(e)).x;
+        double y1 = Access::at(Vertices, origin(e)).y;
+        double x2 = Access::at(Vertices, target(e)).x;
+        double y2 = Access::at(Vertices, target(e)).y;
         return pow(x1-x2,2) + pow(y1-y2,2); //no sqrt for performance
     }
 
@@ -597,18 +1059,18 @@ public:
     //Return triangle of the face incident to edge e
     //Input: e is the edge
     //output: array with the vertices of the triangle
-    _triangle incident_face(int e)
+    _triangle incident_face(index_t e)
     {   
-        _triangle face;  
-        int nxt = e;
-        int init_vertex = origin(nxt);
-        int curr_vertex = -1;
+        _triangle face{};  
+        index_t nxt = e;
+        index_t init_vertex = origin(nxt);
+        index_t curr_vertex = -1;
         int i = 0;
         while ( curr_vertex != init_vertex )
         {
             nxt = next(nxt);            
             curr_vertex = origin(nxt);
-            face.at(i) = curr_vertex;
+            Access::at(face, i) = curr_vertex;
             i++;
         }
         return face;
@@ -619,12 +1081,12 @@ public:
     //Output: true if the triangle is counterclockwise, false otherwise
     bool is_counterclockwise(_triangle tr)
     {
-        int v0 = tr.at(0);
-        int v1 = tr.at(1);
-        int v2 = tr.at(2);
+        index_t v0 = Access::at(tr, 0);
+        index_t v1 = Access::at(tr, 1);
+        index_t v2 = Access::at(tr, 2);
         double area = 0.0;
             //int val = (p2.y - p1.y) * (p3.x - p2.x) - (p2.x - p1.x) * (p3.y - p2.y);
-        area = (Vertices.at(v2).x - Vertices.at(v1).x) * (Vertices.at(v1).y - Vertices.at(v0).y) - (Vertices.at(v2).y - Vertices.at(v1).y) * (Vertices.at(v1).x - Vertices.at(v0).x);
+        area = (Access::at(Vertices, v2).x - Access::at(Vertices, v1).x) * (Access::at(Vertices, v1).y - Access::at(Vertices, v0).y) - (Access::at(Vertices, v2).y - Access::at(Vertices, v1).y) * (Access::at(Vertices, v1).x - Access::at(Vertices, v0).x);
         if(area < 0)
             return true;
         return false;
@@ -633,105 +1095,110 @@ public:
 //Given a edge with vertex origin v, return the next coutnerclockwise edge of v with v as origin
 //Input: e is the edge
 //Output: the next counterclockwise edge of v
-int CCW_edge_to_vertex(int e)
+index_t CCW_edge_to_vertex(index_t e)
 {
-    int twn, nxt;
-    nxt = HalfEdges.at(e).prev;
-    twn = HalfEdges.at(nxt).twin;
+    index_t twn, nxt;
+    nxt = Access::at(HalfEdges, e).prev;
+    twn = Access::at(HalfEdges, nxt).twin;
     return twn;
 }    
 
 //Given a edge with vertex origin v, return the prev clockwise edge of v with v as origin
 //Input: e is the edge
 //Output: the prev clockwise edge of v
-int CW_edge_to_vertex(int e)
+index_t CW_edge_to_vertex(index_t e)
 {
-    int twn, nxt;
-    twn = HalfEdges.at(e).twin;
-    nxt = HalfEdges.at(twn).next;
+    index_t twn, nxt;
+    twn = Access::at(HalfEdges, e).twin;
+    nxt = Access::at(HalfEdges, twn).next;
     return nxt;
 }    
 
     //return number of faces
-    int faces(){
+    index_t faces(){
         return n_faces;
     }
 
     //Return number of halfedges
-    int halfEdges(){
+    index_t halfEdges(){
         return n_halfedges;
     }
 
     //Return number of vertices
-    int vertices(){
+    index_t vertices(){
         return n_vertices;
     }
 
     //list of triangles where true if the halfege generate a unique face, false if the face is generated by another halfedge
     //Replace by a triangle iterator
-    std::vector<int> get_Triangles(){
+    std::vector<index_t> get_Triangles(){
         triangle_list.reserve(n_faces);
         for(std::size_t i = 0; i < n_faces; i++)
             triangle_list.push_back(3*i);
         return triangle_list;
     }
 
-    double get_PointX(int i){
-        return Vertices.at(i).x;
+    double get_PointX(index_t i){
+        return Access::at(Vertices, i).x;
     }
 
-    double get_PointY(int i){
-        return Vertices.at(i).y;
+    double get_PointY(index_t i){
+        return Access::at(Vertices, i).y;
     }
 
-    int get_size(){
+    //Pointer to the vertices, used to view the coordinates without copying them
+    const vertex* get_Vertices(){
+        return Vertices.data();
+    }
+
+    index_t get_size(){
         return Vertices.size();
     }
 
-    void set_PointX(int i, double new_x){
-        Vertices.at(i).x = new_x;
+    void set_PointX(index_t i, double new_x){
+        Access::at(Vertices, i).x = new_x;
     }
 
-    void set_PointY(int i, double new_y){
-        Vertices.at(i).y = new_y;
+    void set_PointY(index_t i, double new_y){
+        Access::at(Vertices, i).y = new_y;
     }
 
     //Calculates the next edge of the face incident to edge e
     //Input: e is the edge
     //Output: the next edge of the face incident to e
-    int next(int e){
-        return HalfEdges.at(e).next;
+    index_t next(index_t e){
+        return Access::at(HalfEdges, e).next;
     }
 
     //Calculates the tail vertex of the edge e
     //Input: e is the edge
     //Output: the tail vertex v of the edge e
-    int origin(int e){
-        return HalfEdges.at(e).origin;
+    index_t origin(index_t e){
+        return Access::at(HalfEdges, e).origin;
     }
 
 
     //Calculates the head vertex of the edge e
     //Input: e is the edge
     //Output: the head vertex v of the edge e
-    int target(int e){
+    index_t target(index_t e){
         //return HalfEdges.at(e).target;
-        return this->origin(HalfEdges.at(e).twin);
+        return this->origin(Access::at(HalfEdges, e).twin);
     }
 
     //Return the twin edge of the edge e
     //Input: e is the edge
     //Output: the twin edge of e
-    int twin(int e){
-        return HalfEdges.at(e).twin;
+    index_t twin(index_t e){
+        return Access::at(HalfEdges, e).twin;
     }
 
     //Return the twin edge of the edge e
     //Input: e is the edge
     //Output: the twin edge of e
-    int prev(int e)
+    index_t prev(index_t e)
     {
-        return HalfEdges.at(e).prev;
+        return Access::at(HalfEdges, e).prev;
     }
 
 
@@ -739,48 +1206,48 @@ int CW_edge_to_vertex(int e)
     //return a edge associate to the node v
     //Input: v is the node
     //Output: the edge associate to the node v
-    int edge_of_vertex(int v)
+    index_t edge_of_vertex(index_t v)
     {
-        return Vertices.at(v).incident_halfedge;
+        return Access::at(Vertices, v).incident_halfedge;
     }
 
     //Input: edge e
     //Output: true if is the face of e is border face
     //        false otherwise
-    bool is_border_face(int e)
+    bool is_border_face(index_t e)
     {
-        return HalfEdges.at(e).is_border;
+        return Access::at(HalfEdges, e).is_border;
     }
 
     // Input: edge e of compressTriangulation
     // Output: true if the edge is an interior face a
     //         false otherwise
-    bool is_interior_face(int e)
+    bool is_interior_face(index_t e)
     {
        return !this->is_border_face(e);
     }
 
     //Input:vertex v
     //Output: the edge incident to v, wiht v as origin
-    bool is_border_vertex(int v)
+    bool is_border_vertex(index_t v)
     {
-        return Vertices.at(v).is_border;
+        return Access::at(Vertices, v).is_border;
     }
 
     //Halfedge update operations
-    void set_next(int e, int nxt)
+    void set_next(index_t e, index_t nxt)
     {
-        HalfEdges.at(e).next = nxt;
+        Access::at(HalfEdges, e).next = nxt;
     }
 
-    void set_prev(int e, int prv)
+    void set_prev(index_t e, index_t prv)
     {
-        HalfEdges.at(e).prev = prv;
+        Access::at(HalfEdges, e).prev = prv;
     }
 
-    void set_incident_halfedge(int v, int e)
+    void set_incident_halfedge(index_t v, index_t e)
     {
-        Vertices.at(v).incident_halfedge = e;
+        Access::at(Vertices, v).incident_halfedge = e;
     }
 
     //void set_face(int e, int f)
@@ -788,10 +1255,10 @@ int CW_edge_to_vertex(int e)
     //    HalfEdges.at(e).face = f;
     //}
 
-int degree(int v)
+int degree(index_t v)
 {
-    int e_curr = edge_of_vertex(v);
-    int e_next = CCW_edge_to_vertex(e_curr);
+    index_t e_curr = edge_of_vertex(v);
+    index_t e_next = CCW_edge_to_vertex(e_curr);
     int adv = 1;
     while (e_next != e_curr)
     {
@@ -801,20 +1268,22 @@ int degree(int v)
     return adv;
 }
 
-int incident_halfedge(int f)
+index_t incident_halfedge(index_t f)
 {
     return 3*f;
 }
 
-int index_face(int e) {
+index_t index_face(index_t e) {
     return e / 3;
 }
 
-int region_face(int f) {
+int region_face(index_t f) {
     if(triangle_regions.size() > 0 && f < triangle_regions.size())
-        return triangle_regions.at(f);
+        return Access::at(triangle_regions, f);
     return 0;
 }
 };
 
+typedef BasicTriangulation<> Triangulation;
+
 #endif
@@ -0,0 +1,262 @@
+// Synthetic triangulations for benchmarks, generated in memory
+// The meshes are returned as arrays in the layout of the Triangulation array constructor,
+// with the neighbours of each triangle so no edge hashing is needed.
+/*
+Basic operations
+    grid_workload(n, seed): jittered regular grid with about n triangles
+    random_delaunay_workload(n, seed): Delaunay triangulation of n/2 random points in the unit square (Triangle)
+    refined_pslg_workload(n, seed): quality refined (q30) mesh of a square with a square hole and about n triangles (Triangle)
+    barrier_tip_workload(n, seed, tips, spiral): about n triangles with a controlled number of barrier-edge tips
+    make_workload(name, n, seed, tips): workload by name (grid, random, pslg, fans, spirals)
+    compute_neighbours(w): neighbours of the triangles of w, by sorting their edges
+    to_triangulation<Access>(): build the half-edge triangulation of a workload with the access policy Access
+*/
+
+#ifndef WORKLOADS_HPP
+#define WORKLOADS_HPP
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <triangulation.hpp>
+
+extern "C" {
+#define ANSI_DECLARATORS
+#define REAL double
+#define VOID void
+#include <triangle/triangle.h>
+#undef REAL
+#undef VOID
+}
+
+struct Workload {
+    std::string name;
+    std::vector<double> xy;  //x0 y0 x1 y1 ...
+    std::vector<int> triangles; //3 vertex indices per triangle, CCW
+    std::vector<int> neighs; //3 neighbours per triangle in .neigh order, -1 on the border
+
+    int n_vertices() const { return static_cast<int>(xy.size() / 2); }
+    int n_triangles() const { return static_cast<int>(triangles.size() / 3); }
+
+    template <typename Access = default_access>
+    BasicTriangulation<Access>* to_triangulation() const {
+        return new BasicTriangulation<Access>(xy.data(), n_vertices(), triangles.data(), n_triangles(), neighs.data());
+    }
+};
+
+//Grid of nx*ny cells with 2 triangles each, the vertices are moved randomly up to 10% of a cell
+//so that the edges of the triangles have different lengths
+inline Workload grid_workload(const long long n, const unsigned int seed) {
+    const int nx = std::max(1, static_cast<int>(std::ceil(std::sqrt(n / 2.0))));
+    const int ny = nx;
+    Workload w;
+    w.name = "grid";
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(-0.1, 0.1);
+    w.xy.reserve(2 * static_cast<std::size_t>(nx + 1) * (ny + 1));
+    for (int j = 0; j <= ny; j++) {
+        for (int i = 0; i <= nx; i++) {
+            bool border = i == 0 || j == 0 || i == nx || j == ny;
+            w.xy.push_back(i + (border ? 0 : jitter(rng)));
+            w.xy.push_back(j + (border ? 0 : jitter(rng)));
+        }
+    }
+
+    //cell (i,j) has the triangles t0 = (v00, v10, v11) and t1 = (v00, v11, v01)
+    auto vertex = [nx](int i, int j) { return j * (nx + 1) + i; };
+    auto t0 = [nx](int i, int j) { return 2 * (j * nx + i); };
+    auto t1 = [nx](int i, int j) { return 2 * (j * nx + i) + 1; };
+    const std::size_t n_triangles = 2 * static_cast<std::size_t>(nx) * ny;
+    w.triangles.reserve(3 * n_triangles);
+    w.neighs.reserve(3 * n_triangles);
+    for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) {
+            int v00 = vertex(i, j), v10 = vertex(i + 1, j), v11 = vertex(i + 1, j + 1), v01 = vertex(i, j + 1);
+            w.triangles.insert(w.triangles.end(), {v00, v10, v11});
+            w.neighs.insert(w.neighs.end(), {i + 1 < nx ? t1(i + 1, j) : -1, t1(i, j), j > 0 ? t1(i, j - 1) : -1});
+            w.triangles.insert(w.triangles.end(), {v00, v11, v01});
+            w.neighs.insert(w.neighs.end(), {j + 1 < ny ? t0(i, j + 1) : -1, i > 0 ? t0(i - 1, j) : -1, t0(i, j)});
+        }
+    }
+    return w;
+}
+
+//Run Triangle with switches on in and move its output into w
+inline void run_triangle(const std::string &switches, triangulateio &in, Workload &w) {
+    triangulateio out = {};
+    std::vector<char> sw(switches.begin(), switches.end());
+    sw.push_back('\0');
+    triangulate(sw.data(), &in, &out, nullptr);
+
+    w.xy.assign(out.pointlist, out.pointlist + 2 * static_cast<std::size_t>(out.numberofpoints));
+    w.triangles.assign(out.trianglelist, out.trianglelist + 3 * static_cast<std::size_t>(out.numberoftriangles));
+    w.neighs.assign(out.neighborlist, out.neighborlist + 3 * static_cast<std::size_t>(out.numberoftriangles));
+    trifree(out.pointlist);
+    trifree(out.pointmarkerlist);
+    trifree(out.trianglelist);
+    trifree(out.neighborlist);
+    trifree(out.segmentlist);
+    trifree(out.segmentmarkerlist);
+}
+
+inline Workload random_delaunay_workload(const long long n, const unsigned int seed) {
+    Workload w;
+    w.name = "random";
+    const int n_points = std::max(3, static_cast<int>(n / 2));
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0.0, 1.0);
+    std::vector<double> points(2 * static_cast<std::size_t>(n_points));
+    for (double &c : points) c = coord(rng);
+
+    triangulateio in = {};
+    in.pointlist = points.data();
+    in.numberofpoints = n_points;
+    run_triangle("zQBn", in, w); //convex hull of the points, 0-based, neighbours
+    return w;
+}
+
+inline Workload refined_pslg_workload(const long long n, const unsigned int seed) {
+    Workload w;
+    w.name = "pslg";
+    //unit square with a square hole in the middle, the seed moves the hole
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> shift(-0.1, 0.1);
+    const double cx = 0.5 + shift(rng), cy = 0.5 + shift(rng), r = 0.1;
+    std::vector<double> points = {0, 0, 1, 0, 1, 1, 0, 1,
+                                  cx - r, cy - r, cx + r, cy - r, cx + r, cy + r, cx - r, cy + r};
+    std::vector<int> segments = {0, 1, 1, 2, 2, 3, 3, 0, 4, 5, 5, 6, 6, 7, 7, 4};
+    std::vector<double> holes = {cx, cy};
+
+    triangulateio in = {};
+    in.pointlist = points.data();
+    in.numberofpoints = 8;
+    in.segmentlist = segments.data();
+    in.numberofsegments = 8;
+    in.holelist = holes.data();
+    in.numberofholes = 1;
+
+    //q30 triangles with the maximum area give on average about half of it
+    const double domain_area = 1.0 - 4 * r * r;
+    const double max_area = 2 * domain_area / std::max(1LL, n);
+    char area[64];
+    std::snprintf(area, sizeof(area), "a%.20f", max_area); //Triangle does not read exponents
+    run_triangle(std::string("pzQBPnq30") + area, in, w);
+    return w;
+}
+
+//Neighbour k of triangle t is the triangle across the edge opposite to its vertex k, -1 on the border
+inline void compute_neighbours(Workload &w) {
+    const std::size_t n_edges = w.triangles.size();
+    std::vector<std::pair<std::uint64_t, std::size_t>> edges(n_edges); //(sorted endpoints, 3*t + k)
+    for (std::size_t i = 0; i < n_edges; i++) {
+        std::size_t t = i / 3, k = i % 3;
+        std::uint64_t a = static_cast<std::uint32_t>(w.triangles[3*t + (k + 1) % 3]);
+        std::uint64_t b = static_cast<std::uint32_t>(w.triangles[3*t + (k + 2) % 3]);
+        edges[i] = {std::min(a, b) << 32 | std::max(a, b), i};
+    }
+    std::sort(edges.begin(), edges.end());
+    w.neighs.assign(n_edges, -1);
+    for (std::size_t i = 0; i + 1 < n_edges; i++) {
+        if (edges[i].first != edges[i + 1].first) continue;
+        w.neighs[edges[i].second] = static_cast<int>(edges[i + 1].second / 3);
+        w.neighs[edges[i + 1].second] = static_cast<int>(edges[i].second / 3);
+        i++;
+    }
+}
+
+//Parameters of the barrier-edge tip workloads
+struct BarrierTipOptions {
+    int tip_degree = 16;      //triangles around each tip vertex, at least 8
+    double tip_density = 1.0; //fraction of the sites of the layout that have a tip, in (0, 1]
+};
+
+//Wheels of long skinny triangles around a center vertex, placed on a jittered grid of sites and
+//joined by the constrained Delaunay triangulation of their rims (Triangle).
+//The spoke lengths of a wheel have a single maximum, which is the terminal edge of every triangle of
+//the wheel, and a single minimum, which is a frontier edge inside that region: a barrier edge whose
+//tip is the center, a vertex of degree tip_degree.
+//fans: the spoke lengths follow a cosine around the wheel
+//spirals: the spoke lengths grow around the wheel, the rim is a spiral closed by one step back
+inline Workload barrier_tip_workload(const long long n, const unsigned int seed, const BarrierTipOptions &tips, const bool spiral) {
+    const int k = tips.tip_degree;
+    if (k < 8) throw std::runtime_error("The tip degree must be at least 8");
+    if (!(tips.tip_density > 0 && tips.tip_density <= 1)) throw std::runtime_error("The tip density must be in (0, 1]");
+
+    Workload w;
+    w.name = spiral ? "spirals" : "fans";
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double pi = std::acos(-1.0);
+    const double radius = 1.0;             //mean spoke length
+    const double spacing = 3.4 * radius;   //distance between sites, the rims do not overlap
+    //the triangulation has about 2 triangles per vertex: k + 1 per wheel
+    const long long n_wheels = std::max(1LL, n / (2 * (k + 1)));
+    const int side = std::max(1, static_cast<int>(std::ceil(std::sqrt(n_wheels / tips.tip_density))));
+    const double length = side * spacing;
+
+    //domain corners, then the rims of the wheels, the centers are added after the Triangle output
+    std::vector<double> points = {0, 0, length, 0, length, length, 0, length};
+    std::vector<int> segments = {0, 1, 1, 2, 2, 3, 3, 0};
+    std::vector<double> centers;
+    for (int b = 0; b < side; b++) {
+        for (int a = 0; a < side; a++) {
+            if (uniform(rng) >= tips.tip_density && !(a == side - 1 && b == side - 1 && centers.empty())) continue;
+            const double cx = (a + 0.5 + 0.03 * (uniform(rng) - 0.5)) * spacing;
+            const double cy = (b + 0.5 + 0.03 * (uniform(rng) - 0.5)) * spacing;
+            const double phase = 2 * pi * uniform(rng);
+            const int first = static_cast<int>(points.size() / 2);
+            for (int j = 0; j < k; j++) {
+                const double theta = phase + 2 * pi * j / k;
+                const double r = spiral ? radius * (0.5 + static_cast<double>(j) / (k - 1))
+                                        : radius * (1 + 0.3 * std::cos(2 * pi * j / k + uniform(rng) * 0.5 / k));
+                points.push_back(cx + r * std::cos(theta));
+                points.push_back(cy + r * std::sin(theta));
+                segments.push_back(first + j);
+                segments.push_back(first + (j + 1) % k);
+            }
+            centers.push_back(cx);
+            centers.push_back(cy);
+        }
+    }
+
+    triangulateio in = {};
+    in.pointlist = points.data();
+    in.numberofpoints = static_cast<int>(points.size() / 2);
+    in.segmentlist = segments.data();
+    in.numberofsegments = static_cast<int>(segments.size() / 2);
+    in.holelist = centers.data(); //the wheels are filled below
+    in.numberofholes = static_cast<int>(centers.size() / 2);
+    run_triangle("pzQBPn", in, w);
+    if (w.n_vertices() != in.numberofpoints)
+        throw std::runtime_error("Triangle added vertices to the barrier-edge tip layout");
+
+    //fan of each wheel around its center
+    const int n_rim_first = 4;
+    for (std::size_t c = 0; c < centers.size() / 2; c++) {
+        const int center = w.n_vertices();
+        w.xy.push_back(centers[2*c]);
+        w.xy.push_back(centers[2*c + 1]);
+        const int first = n_rim_first + static_cast<int>(c) * k;
+        for (int j = 0; j < k; j++)
+            w.triangles.insert(w.triangles.end(), {center, first + j, first + (j + 1) % k});
+    }
+    compute_neighbours(w);
+    return w;
+}
+
+inline Workload make_workload(const std::string &name, const long long n, const unsigned int seed,
+                              const BarrierTipOptions &tips = BarrierTipOptions()) {
+    if (name == "grid") return grid_workload(n, seed);
+    if (name == "random") return random_delaunay_workload(n, seed);
+    if (name == "pslg") return refined_pslg_workload(n, seed);
+    if (name == "fans") return barrier_tip_workload(n, seed, tips, false);
+    if (name == "spirals") return barrier_tip_workload(n, seed, tips, true);
+    throw std::runtime_error("Unknown workload: " + name + " (expected grid, random, pslg, fans or spirals)");
+}
+
+#endif // WORKLOADS_HPP
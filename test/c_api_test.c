@@ -0,0 +1,42 @@
+/* Test of the C interface of libpolylla (src/polylla_c.h), run by run_tests.sh
+   A square split in 4 triangles around its centre: the longest edges are the sides of the square,
+   so every triangle is a polygon. Nothing is printed on success, the library is silent on stdout. */
+
+#include <stdio.h>
+#include <string.h>
+#include <polylla_c.h>
+
+static int fail(const char *message) {
+    fprintf(stderr, "c_api_test: %s\n", message);
+    return 1;
+}
+
+int main(void) {
+    const double xy[] = {0, 0, 1, 0, 1, 1, 0, 1, 0.5, 0.5};
+    const int tri[] = {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+    const int neigh[] = {1, 3, -1, 2, 0, -1, 3, 1, -1, 0, 2, -1};
+    const int bad_tri[] = {0, 1, 4, 1, 2, 4, 2, 3, 7, 3, 0, 4};
+
+    for (int with_neigh = 0; with_neigh < 2; with_neigh++) {
+        polylla_mesh *mesh = polylla_create(xy, 5, tri, 4, with_neigh ? neigh : NULL, NULL, NULL);
+        if (mesh == NULL) return fail(polylla_last_error());
+        const int64_t *offsets = polylla_polygon_offsets(mesh);
+        const int *vertices = polylla_polygon_vertices(mesh);
+        if (polylla_num_polygons(mesh) != 4 || polylla_num_vertices(mesh) != 5)
+            return fail("expected 4 polygons and 5 vertices");
+        for (int p = 0; p < 4; p++) {
+            if (offsets[p+1] - offsets[p] != 3) return fail("expected triangles");
+            for (int64_t i = offsets[p]; i < offsets[p+1]; i++)
+                if (vertices[i] < 0 || vertices[i] >= 5) return fail("vertex index out of range");
+        }
+        if (polylla_polygon_regions(mesh) != NULL) return fail("regions without use_regions");
+        if (polylla_vertex_coordinates(mesh)[8] != 0.5) return fail("wrong coordinates");
+        polylla_destroy(mesh);
+    }
+
+    if (polylla_create(xy, 5, bad_tri, 4, NULL, NULL, NULL) != NULL)
+        return fail("a vertex index out of range was accepted");
+    if (strstr(polylla_last_error(), "out of range") == NULL)
+        return fail("polylla_last_error does not report the index out of range");
+    return 0;
+}
@@ -47,6 +47,10 @@ TIMEOUT=60
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 # Polylla binary path relative to script location
 POLYLLA_BIN="$SCRIPT_DIR/../build/Polylla"
+# 64-bit index build, next to the Polylla binary
+POLYLLA64_BIN="$(dirname "$(realpath "$POLYLLA_BIN")")/Polylla64"
+POLYLLA_CLIENT_BIN="$(dirname "$(realpath "$POLYLLA_BIN")")/polylla_client"
+POLYLLA_LIB_DIR="$(dirname "$(realpath "$POLYLLA_BIN")")"
 TEST_DIR="test_files"
 LOG_FILE="test_results.log"
 
@@ -483,6 +487,14 @@ run_test "DistMesh smoothing" "smoothing" \
     "$POLYLLA_BIN --neigh --smooth distmesh --target-length 500 --iterations 10 pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
     "pikachu.1"
 
+run_test "Laplacian CG smoothing" "smoothing" \
+    "$POLYLLA_BIN --neigh --smooth laplacian-cg --iterations 200 pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
+    "pikachu.1"
+
+run_test "Laplacian CG smoothing with move validation" "smoothing" \
+    "$POLYLLA_BIN --neigh --smooth laplacian-cg --iterations 200 --validate-moves pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
+    "pikachu.1"
+
 echo
 
 echo -e "${BLUE}🗺️  Region Tests${NC}"
@@ -519,6 +531,10 @@ run_test "OFF + Regions + Edge-ratio smoothing" "combined" \
     "$POLYLLA_BIN --off --region --smooth laplacian-edge-ratio --iterations 15 pikachu_triangle.off" \
     "pikachu_triangle"
 
+run_test "Regions + Laplacian CG smoothing" "combined" \
+    "$POLYLLA_BIN --neigh --region --smooth laplacian-cg --iterations 200 pikachu_regiones.1.node pikachu_regiones.1.ele pikachu_regiones.1.neigh" \
+    "pikachu_regiones.1"
+
 run_test "Triangle + Regions + DistMesh + High iterations" "combined" \
     "$POLYLLA_BIN --neigh --region --smooth distmesh --target-length 300 --iterations 20 pikachu_regiones.1.node pikachu_regiones.1.ele pikachu_regiones.1.neigh" \
     "pikachu_regiones.1"
@@ -549,6 +565,98 @@ run_test "DistMesh with large target length" "edge_cases" \
     "$POLYLLA_BIN --neigh --smooth distmesh --target-length 2000 --iterations 5 pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
     "pikachu.1"
 
+run_test "Quality measures" "edge_cases" \
+    "$POLYLLA_BIN --neigh --quality pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
+    "pikachu.1"
+
+run_test "Quality measures after smoothing" "edge_cases" \
+    "$POLYLLA_BIN --off --smooth laplacian --iterations 10 --quality pikachu_triangle.off" \
+    "pikachu_triangle"
+
+run_test "Polygon kernels" "edge_cases" \
+    "$POLYLLA_BIN --neigh --kernel pikachu.1.node pikachu.1.ele pikachu.1.neigh && test -s pikachu.1.kernel && rm -f pikachu.1.kernel" \
+    "pikachu.1"
+
+run_test "Binary VTU output with regions" "edge_cases" \
+    "$POLYLLA_BIN --neigh --region -O vtu pikachu_regiones.1.node pikachu_regiones.1.ele pikachu_regiones.1.neigh && grep -q 'Name=\"region\"' pikachu_regiones.1.vtu && rm -f pikachu_regiones.1.vtu && $POLYLLA_BIN --neigh --region pikachu_regiones.1.node pikachu_regiones.1.ele pikachu_regiones.1.neigh" \
+    "pikachu_regiones.1"
+
+run_test "Phase tracing" "edge_cases" \
+    "$POLYLLA_BIN --neigh --smooth laplacian --iterations 5 --trace pikachu.1.trace.json pikachu.1.node pikachu.1.ele pikachu.1.neigh && grep -q smoothing_iteration pikachu.1.trace.json && rm -f pikachu.1.trace.json" \
+    "pikachu.1"
+
+run_test "Memory accounting" "edge_cases" \
+    "$POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh && grep -q memory_construct_interior_halfedges_peak_heap pikachu.1.json && grep -q memory_peak_rss pikachu.1.json" \
+    "pikachu.1"
+
+run_test "Performance counters" "edge_cases" \
+    "$POLYLLA_BIN --neigh --perf-counters pikachu.1.node pikachu.1.ele pikachu.1.neigh && grep -q perf_counters_available pikachu.1.json && ! $POLYLLA_BIN --serve perf_counters.sock --perf-counters && test ! -e perf_counters.sock" \
+    "pikachu.1"
+
+run_test "Generated barrier-edge tips" "edge_cases" \
+    "$POLYLLA_BIN --generate spirals --size 5000 --tip-degree 12 && grep -q '\"n_polygons_to_repair\": [1-9]' spirals_5000_k12_polylla.json" \
+    "spirals_5000_k12"
+
+run_test "64-bit indices" "edge_cases" \
+    "$POLYLLA64_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh && mv pikachu.1.off pikachu.1.off64 && $POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh && cmp pikachu.1.off pikachu.1.off64 && rm -f pikachu.1.off64" \
+    "pikachu.1"
+
+run_test "Hilbert reorder with restored vertex order" "edge_cases" \
+    "$POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh && awk 'NR==2{n=\$1} NR<=n+2' pikachu.1.off > pikachu.1.vertices && $POLYLLA_BIN --neigh --reorder hilbert --restore-order pikachu.1.node pikachu.1.ele pikachu.1.neigh && awk 'NR==2{n=\$1} NR<=n+2' pikachu.1.off | cmp - pikachu.1.vertices && grep -q time_to_reorder pikachu.1.json && rm -f pikachu.1.vertices" \
+    "pikachu.1"
+
+run_test "Polygons sorted along the Hilbert curve" "edge_cases" \
+    "$POLYLLA_BIN --off pikachu_triangle.off && sort pikachu_triangle_polylla.off > pikachu_triangle.sorted && $POLYLLA_BIN --off --sort-polygons hilbert pikachu_triangle.off && sort pikachu_triangle_polylla.off | cmp - pikachu_triangle.sorted && grep -q time_to_sort_polygons pikachu_triangle_polylla.json && rm -f pikachu_triangle.sorted" \
+    "pikachu_triangle"
+
+run_test "File-backed storage" "edge_cases" \
+    "$POLYLLA_BIN --generate random --size 20000 && mv random_20000_polylla.off random_20000.heap && $POLYLLA_BIN --generate random --size 20000 --storage file --storage-dir . && cmp random_20000_polylla.off random_20000.heap && grep -q memory_storage_file_peak random_20000_polylla.json && rm -f random_20000.heap" \
+    "random_20000"
+
+run_test "Pinned threads with NUMA summary" "edge_cases" \
+    "OMP_NUM_THREADS=2 $POLYLLA_BIN --off --pin cores pikachu_triangle.off && grep -q '\"numa_pin\": \"cores\"' pikachu_triangle_polylla.json && grep -q numa_node_0_bytes pikachu_triangle_polylla.json" \
+    "pikachu_triangle"
+
+run_test "Batch manifest with a failing item" "edge_cases" \
+    "$POLYLLA_BIN --off pikachu_triangle.off && mv pikachu_triangle_polylla.off pikachu_triangle.single && printf -- '# batch test\\n--off pikachu_triangle.off\\n--off missing.off\\n--neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh\\n' > batch_manifest.txt && ! $POLYLLA_BIN --batch batch_manifest.txt --jobs 2 && cmp pikachu_triangle_polylla.off pikachu_triangle.single && grep -q '\"succeeded\": 2' batch_manifest_batch.json && grep -q '\"failed\": 1' batch_manifest_batch.json && ! grep -q '_allocations' pikachu_triangle_polylla.json && printf -- '--generate grid --size 200000\\n--generate grid --size 2000\\n' > batch_manifest.txt && $POLYLLA_BIN --batch batch_manifest.txt --jobs 1 && python3 -c 'import json; a, b = [sum(v for k, v in json.load(open(f)).items() if k.endswith(\"_allocations\")) for f in (\"grid_200000_polylla.json\", \"grid_2000_polylla.json\")]; exit(not 0 <= b < a)' && rm -f pikachu_triangle.single batch_manifest.txt batch_manifest_batch.json grid_200000_polylla.* grid_2000_polylla.*" \
+    "pikachu_triangle"
+
+run_test "Sweep of configurations on one input" "edge_cases" \
+    "$POLYLLA_BIN --neigh --smooth laplacian --iterations 10 pikachu.1.node pikachu.1.ele pikachu.1.neigh && mv pikachu.1.off pikachu.1.single && printf -- '# sweep test\\n--smooth laplacian --iterations 10\\n--region\\n--quality\\n' > sweep_configs.txt && ! $POLYLLA_BIN --neigh --sweep sweep_configs.txt --jobs 2 pikachu.1.node pikachu.1.ele pikachu.1.neigh && cmp pikachu.1_1.off pikachu.1.single && test -f pikachu.1_3.off && grep -q '\"succeeded\": 2' sweep_configs_sweep.json && rm -f pikachu.1.single pikachu.1_1.* pikachu.1_3.* sweep_configs.txt sweep_configs_sweep.json && $POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
+    "pikachu.1"
+
+run_test "Serve requests over a Unix socket" "edge_cases" \
+    "timeout 60 $POLYLLA_BIN --serve polylla_test.sock --jobs 2 & while [ ! -S polylla_test.sock ]; do sleep 0.1; done && $POLYLLA_CLIENT_BIN polylla_test.sock mesh pikachu_triangle.off --write pikachu_triangle.client && $POLYLLA_CLIENT_BIN polylla_test.sock run --off pikachu_triangle.off && ! $POLYLLA_CLIENT_BIN polylla_test.sock run --off missing.off && $POLYLLA_CLIENT_BIN polylla_test.sock shutdown && wait && cmp pikachu_triangle_polylla.off pikachu_triangle.client && rm -f pikachu_triangle.client" \
+    "pikachu_triangle"
+
+run_test "Serve rejects a mesh over --serve-max-triangles" "edge_cases" \
+    "timeout 60 $POLYLLA_BIN --serve polylla_test.sock --serve-max-triangles 10 & while [ ! -S polylla_test.sock ]; do sleep 0.1; done && ! $POLYLLA_CLIENT_BIN polylla_test.sock mesh pikachu_triangle.off 2> serve_max.err && grep -q serve-max-triangles serve_max.err && $POLYLLA_CLIENT_BIN polylla_test.sock run --off pikachu_triangle.off && $POLYLLA_CLIENT_BIN polylla_test.sock shutdown && wait && rm -f serve_max.err" \
+    "pikachu_triangle"
+
+run_test "Stdin input and stdout output" "edge_cases" \
+    "cat pikachu.1.node pikachu.1.ele pikachu.1.neigh | $POLYLLA_BIN --neigh - --stdout > stdin.streamed && test -f stdin.json && $POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh && cmp pikachu.1.off stdin.streamed && rm -f stdin.streamed stdin.json" \
+    "pikachu.1"
+
+run_test "Pipelined read of node, ele and neigh" "edge_cases" \
+    "$POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh --pipelined-read && grep -q pipelined_read_overlap pikachu.1.json && mv pikachu.1.off pikachu.1.pipelined && $POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh && cmp pikachu.1.off pikachu.1.pipelined && rm -f pikachu.1.pipelined" \
+    "pikachu.1"
+
+run_test "Truncated input is rejected" "edge_cases" \
+    "head -n -20 pikachu.1.ele > truncated.1.ele && ! $POLYLLA_BIN --neigh pikachu.1.node truncated.1.ele pikachu.1.neigh && ! $POLYLLA_BIN --ele pikachu.1.node truncated.1.ele && rm -f truncated.1.ele && $POLYLLA_BIN --neigh pikachu.1.node pikachu.1.ele pikachu.1.neigh" \
+    "pikachu.1"
+
+run_test "Oversized allocation throws std::bad_alloc" "edge_cases" \
+    "printf 'OFF\\n900000000 10 0\\n0 0 0\\n' > oversized.off && (ulimit -v 2000000; $POLYLLA_BIN --off oversized.off 2> oversized.err; test \$? -eq 1) && grep -q bad_alloc oversized.err && rm -f oversized.off oversized.err && $POLYLLA_BIN --off pikachu_triangle.off" \
+    "pikachu_triangle"
+
+run_test "C interface of libpolylla" "edge_cases" \
+    "cc -std=c99 -I ../../src ../c_api_test.c -L $POLYLLA_LIB_DIR -lpolylla -Wl,-rpath,$POLYLLA_LIB_DIR -o c_api_test && ./c_api_test > c_api_test.out && test ! -s c_api_test.out && rm -f c_api_test c_api_test.out && $POLYLLA_BIN --off pikachu_triangle.off" \
+    "pikachu_triangle"
+
+run_test "Binary PLY output" "edge_cases" \
+    "$POLYLLA_BIN --off -O ply pikachu_triangle.off && head -n 2 pikachu_triangle_polylla.ply | grep -q binary_little_endian && rm -f pikachu_triangle_polylla.ply && $POLYLLA_BIN --off pikachu_triangle.off" \
+    "pikachu_triangle"
+
 run_test "OFF with 0 iterations" "edge_cases" \
     "$POLYLLA_BIN --off --smooth laplacian --iterations 0 pikachu_triangle.off" \
     "pikachu_triangle"
@@ -632,6 +740,9 @@ run_fail_test "Non-existent .poly file" "error_handling" \
 run_fail_test "Invalid smoothing method" "error_handling" \
     "$POLYLLA_BIN --neigh --smooth invalid_method pikachu.1.node pikachu.1.ele pikachu.1.neigh"
 
+run_fail_test "Invalid output format" "error_handling" \
+    "$POLYLLA_BIN --neigh -O stl pikachu.1.node pikachu.1.ele pikachu.1.neigh"
+
 run_fail_test "Invalid target length (negative)" "error_handling" \
     "$POLYLLA_BIN --neigh --smooth distmesh --target-length -100 pikachu.1.node pikachu.1.ele pikachu.1.neigh"
 
@@ -0,0 +1,196 @@
+// polylla_client: client of Polylla --serve (serve_protocol.hpp)
+// run sends a command line to the server, which reads the inputs and writes the outputs itself.
+// mesh reads a triangulation from an OFF file, sends its arrays inline and receives the polygons as
+// CSR arrays, optionally written as an OFF file. --repeat sends the same request several times on
+// one connection and prints the mean round trip, to measure the latency of the server.
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_set>
+#include <serve_protocol.hpp>
+
+void print_usage(const char *program) {
+    std::cout << "Usage: " << program << " SOCKET COMMAND [ARGS...]\n\n";
+    std::cout << "Commands:\n";
+    std::cout << "  run ARGS...              Process an input on the server, e.g. run --off mesh.off --smooth laplacian\n";
+    std::cout << "  mesh FILE.off [OPTIONS]  Send the triangles of FILE.off and receive the polygons, the other\n";
+    std::cout << "                           options are Polylla options, e.g. --smooth laplacian\n";
+    std::cout << "  shutdown                 Stop the server\n\n";
+    std::cout << "Options of run and mesh:\n";
+    std::cout << "  --repeat N               Send the request N times and print the mean round trip (default: 1)\n";
+    std::cout << "  --write FILE             mesh: write the polygons to FILE in OFF format\n";
+}
+
+struct off_triangulation {
+    std::vector<double> xy;
+    std::vector<int32_t> tri;
+};
+
+//Vertices and triangles of an OFF file, the lines starting with # are comments
+off_triangulation read_off(const std::string &filename) {
+    std::ifstream in(filename);
+    if (!in.is_open())
+        throw std::runtime_error("unable to open " + filename);
+    std::string line;
+    auto next_line = [&]() {
+        while (std::getline(in, line))
+            if (!line.empty() && line[0] != '#' && line.find_first_not_of(" \t\r") != std::string::npos) return true;
+        return false;
+    };
+    if (!next_line() || line.compare(0, 3, "OFF") != 0)
+        throw std::runtime_error(filename + " is not an OFF file");
+    if (!next_line())
+        throw std::runtime_error(filename + " has no sizes");
+    long long nv = 0, nf = 0;
+    std::istringstream(line) >> nv >> nf;
+    off_triangulation mesh;
+    mesh.xy.reserve(2 * nv);
+    for (long long v = 0; v < nv && next_line(); v++) {
+        double x = 0, y = 0;
+        std::istringstream(line) >> x >> y;
+        mesh.xy.push_back(x);
+        mesh.xy.push_back(y);
+    }
+    mesh.tri.reserve(3 * nf);
+    for (long long f = 0; f < nf && next_line(); f++) {
+        int k = 0;
+        int32_t a = 0, b = 0, c = 0;
+        std::istringstream(line) >> k >> a >> b >> c;
+        if (k != 3)
+            throw std::runtime_error(filename + " has a face that is not a triangle");
+        mesh.tri.insert(mesh.tri.end(), {a, b, c});
+    }
+    if (static_cast<long long>(mesh.xy.size()) != 2 * nv || static_cast<long long>(mesh.tri.size()) != 3 * nf)
+        throw std::runtime_error(filename + " is truncated");
+    return mesh;
+}
+
+struct polygon_reply {
+    std::vector<int64_t> offsets;
+    std::vector<int32_t> vertices;
+    std::vector<double> xy;
+    std::vector<int32_t> regions;
+};
+
+template <typename T>
+bool read_array(SocketReader &reader, std::vector<T> &values, const std::size_t n) {
+    values.resize(n);
+    return reader.read(values.data(), n * sizeof(T));
+}
+
+//Same file as Polylla --off writes, the header counts the edges shared by the polygons once
+void write_polygons_off(const std::string &filename, const polygon_reply &polygons) {
+    std::ofstream out(filename);
+    const std::size_t nv = polygons.xy.size() / 2, np = polygons.offsets.size() - 1;
+    std::unordered_set<uint64_t> edges;
+    for (std::size_t p = 0; p < np; p++) {
+        for (int64_t i = polygons.offsets[p]; i < polygons.offsets[p+1]; i++) {
+            const uint32_t a = polygons.vertices[i];
+            const uint32_t b = polygons.vertices[i + 1 < polygons.offsets[p+1] ? i + 1 : polygons.offsets[p]];
+            edges.insert(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+        }
+    }
+    out << "OFF\n" << nv << " " << np << " " << edges.size() << "\n" << std::setprecision(15);
+    for (std::size_t v = 0; v < nv; v++)
+        out << polygons.xy[2*v] << " " << polygons.xy[2*v+1] << " 0\n";
+    for (std::size_t p = 0; p < np; p++) {
+        out << polygons.offsets[p+1] - polygons.offsets[p];
+        for (int64_t i = polygons.offsets[p]; i < polygons.offsets[p+1]; i++)
+            out << " " << polygons.vertices[i];
+        out << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
+        print_usage(argv[0]);
+        return argc < 3 ? 1 : 0;
+    }
+    const std::string socket_path = argv[1], command = argv[2];
+    int repeat = 1;
+    std::string write_file;
+    std::vector<std::string> arguments;
+    try {
+        for (int i = 3; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--repeat" && i + 1 < argc) repeat = std::stoi(argv[++i]);
+            else if (arg == "--write" && i + 1 < argc) write_file = argv[++i];
+            else arguments.push_back(arg);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: invalid number in the arguments" << std::endl;
+        return 1;
+    }
+    if (repeat < 1 || (command != "run" && command != "mesh" && command != "shutdown") || (command == "mesh" && arguments.empty())) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        off_triangulation mesh;
+        if (command == "mesh") {
+            mesh = read_off(arguments[0]);
+            arguments.erase(arguments.begin());
+        }
+        //The server splits the arguments with std::quoted
+        std::ostringstream request;
+        request << command;
+        if (command == "mesh")
+            request << " " << mesh.xy.size() / 2 << " " << mesh.tri.size() / 3 << " 0";
+        for (const std::string &arg : arguments)
+            request << " " << std::quoted(arg);
+
+        const int fd = connect_unix(socket_path);
+        SocketReader reader(fd);
+        std::string reply;
+        polygon_reply polygons;
+        double total_ms = 0;
+        for (int r = 0; r < repeat; r++) {
+            auto t_start = std::chrono::high_resolution_clock::now();
+            bool sent = write_line(fd, request.str());
+            if (sent && command == "mesh")
+                sent = write_all(fd, mesh.xy.data(), mesh.xy.size() * sizeof(double)) &&
+                       write_all(fd, mesh.tri.data(), mesh.tri.size() * sizeof(int32_t));
+            if (!sent || !reader.read_line(reply))
+                throw std::runtime_error("the server closed the connection");
+            if (reply.compare(0, 3, "ok ") != 0) {
+                std::cerr << reply << std::endl;
+                close(fd);
+                return 1;
+            }
+            if (command == "mesh") {
+                std::istringstream fields(reply.substr(3));
+                std::size_t np = 0, nv = 0, nnz = 0;
+                int flags = 0;
+                fields >> np >> nv >> nnz >> flags;
+                if (!read_array(reader, polygons.offsets, np + 1) || !read_array(reader, polygons.vertices, nnz) ||
+                    !read_array(reader, polygons.xy, 2 * nv) || ((flags & MESH_REGIONS) && !read_array(reader, polygons.regions, np)))
+                    throw std::runtime_error("the server closed the connection");
+            }
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_start).count();
+        }
+        close(fd);
+
+        std::cout << reply << std::endl;
+        if (repeat > 1)
+            std::cout << "mean round trip of " << repeat << " requests: " << total_ms / repeat << " ms" << std::endl;
+        if (command == "mesh") {
+            std::cout << polygons.offsets.size() - 1 << " polygons, " << polygons.xy.size() / 2 << " vertices" << std::endl;
+            if (!write_file.empty()) {
+                write_polygons_off(write_file, polygons);
+                std::cout << "output off in " << write_file << std::endl;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}